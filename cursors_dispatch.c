@@ -0,0 +1,80 @@
+/*
+ * cursors_dispatch.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Shared GetNextEvent dispatcher for cooperating keyboard INITs: registering
+ *  a handler, and running the handlers over one event. See cursors_dispatch.h.
+ *
+ * Note: this file must NOT include SetUpA4.h, and must not use globals, so
+ *  that it can run anywhere, with or without A4 set up. The host tools
+ *  (tools/) build it as is.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_dispatch.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+// Adds a key handler to a dispatcher published by another INIT (or by us).
+//   Only a dispatcher of exactly CURSORS_DISPATCH_VERSION is touched: we only
+//   know how to write that layout. INIT time only
+// @param	dispatcher: the dispatcher to join
+// @param	handler: the key handler to add
+// @return	Returns true if the handler was added, false if wrong version or full
+bool CursorsDispatchRegister(CursorsDispatcher *dispatcher, CursorsKeyHandlerProcPtr handler)
+{
+	if (dispatcher->version != CURSORS_DISPATCH_VERSION || dispatcher->handler_count >= CURSORS_DISPATCH_MAX_HANDLERS)
+	{
+		return false;
+	}
+
+	// handler slot first, then count, so dispatcher never sees a half-registered entry
+	dispatcher->handler[dispatcher->handler_count] = handler;
+	dispatcher->handler_count++;
+
+	return true;
+}
+
+
+// Runs every registered handler over one keyDown/autoKey event, in
+//   registration order, stopping early if a handler swallows the event
+// @param	dispatcher: the dispatcher whose handlers to run
+// @param	theEvent: a keyDown or autoKey event; handlers may modify it
+// @return	Returns true if a handler swallowed the event (turned it into a null event)
+bool CursorsDispatchKey(const CursorsDispatcher *dispatcher, EventRecord *theEvent)
+{
+	int16_t		i;
+
+	for (i = 0; i < dispatcher->handler_count; i++)
+	{
+		(*dispatcher->handler[i])(theEvent);
+
+		if (theEvent->what == nullEvent)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,115 @@
+/*
+ * cursors_dispatch.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Shared GetNextEvent dispatcher for cooperating keyboard INITs.
+ *
+ * Every key remapping INIT that patches GetNextEvent on its own adds another
+ *  trap hop (and another A4 setup) to every single event. Instead, the first
+ *  cooperating INIT to load installs one GetNextEvent patch and publishes a
+ *  CursorsDispatcher through Gestalt. INITs that load later look it up and
+ *  add their key handler to it rather than patching the trap again, so the
+ *  chain on the real trap stays at one hop no matter how many are loaded.
+ *
+ * To register with an existing dispatcher (at INIT time only):
+ *   if (Gestalt(CURSORS_DISPATCH_SELECTOR, &response) == noErr)
+ *   {
+ *     dispatcher = (CursorsDispatcher*)response;
+ *     if (dispatcher->version == CURSORS_DISPATCH_VERSION &&
+ *         dispatcher->handler_count < CURSORS_DISPATCH_MAX_HANDLERS)
+ *     {
+ *       dispatcher->handler[dispatcher->handler_count] = MyKeyHandler;
+ *       dispatcher->handler_count++;
+ *     }
+ *   }
+ * (or build cursors_dispatch.c in and call CursorsDispatchRegister())
+ *
+ * The handler slot is written before the count is bumped, so the dispatcher
+ *  never sees a half-registered entry.
+ *
+ * Only register with a dispatcher whose version matches exactly. A future
+ *  version may lay out CursorsDispatcher differently, so an INIT that finds
+ *  a version it does not know patches the trap on its own, as if no
+ *  dispatcher were installed.
+ */
+
+#ifndef CURSORS_DISPATCH_H_
+#define CURSORS_DISPATCH_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define CURSORS_DISPATCH_SELECTOR		'CCkd'	// Gestalt selector; response is a CursorsDispatcher*
+#define CURSORS_DISPATCH_VERSION		1		// bump if CursorsDispatcher layout changes; joiners need an exact match
+#define CURSORS_DISPATCH_MAX_HANDLERS	8		// max number of cooperating INITs
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+// Key handlers are called once per keyDown/autoKey event, in registration
+//  order, after the original GetNextEvent has filled in the EventRecord.
+//  A handler may modify the event in place. A handler may swallow the event
+//  by setting theEvent->what to nullEvent; later handlers are then skipped.
+//  Handlers live in another INIT's code, so they must set up their own A4.
+typedef pascal void (*CursorsKeyHandlerProcPtr)(EventRecord *theEvent);
+
+typedef struct CursorsDispatcher
+{
+	int16_t						version;
+	int16_t						handler_count;
+	CursorsKeyHandlerProcPtr	handler[CURSORS_DISPATCH_MAX_HANDLERS];
+} CursorsDispatcher;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// Adds a key handler to a dispatcher published by another INIT (or by us).
+//   Only a dispatcher of exactly CURSORS_DISPATCH_VERSION is touched: we only
+//   know how to write that layout. INIT time only
+// @param	dispatcher: the dispatcher to join
+// @param	handler: the key handler to add
+// @return	Returns true if the handler was added, false if wrong version or full
+bool CursorsDispatchRegister(CursorsDispatcher *dispatcher, CursorsKeyHandlerProcPtr handler);
+
+// Runs every registered handler over one keyDown/autoKey event, in
+//   registration order, stopping early if a handler swallows the event
+// @param	dispatcher: the dispatcher whose handlers to run
+// @param	theEvent: a keyDown or autoKey event; handlers may modify it
+// @return	Returns true if a handler swallowed the event (turned it into a null event)
+bool CursorsDispatchKey(const CursorsDispatcher *dispatcher, EventRecord *theEvent);
+
+
+#endif /* CURSORS_DISPATCH_H_ */
@@ -0,0 +1,562 @@
+/*
+ * cursors_journal.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Keystroke journal for Custom Cursors: ring buffer on the event path, file
+ *  reads and writes and macro playback deferred to idle time. See
+ *  cursors_journal.h.
+ *
+ * Note: this file must NOT include SetUpA4.h. In a multi-file THINK C code
+ *  resource, only custom_cursors.c can set up A4; every function here is
+ *  called from there with A4 already in place.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_journal.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+#include <Files.h>
+#include <Memory.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define JOURNAL_RING_SIZE			128		// records (16 bytes each). must be a power of 2
+#define JOURNAL_RING_MASK			(JOURNAL_RING_SIZE - 1)
+#define JOURNAL_FLUSH_COUNT			(JOURNAL_RING_SIZE / 2)	// write out now, even if user still typing
+#define JOURNAL_FLUSH_TICKS			90		// 1.5 seconds with no keys = user paused, safe to hit the disk
+
+#define JOURNAL_FILE_CREATOR		'CCur'
+#define JOURNAL_FILE_TYPE			'CCjr'
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// LOGIC:
+//   one producer (the event path, moves head) and one consumer (idle time,
+//   moves tail). each side only ever writes its own index, and 68000 word
+//   stores are atomic, so the two never need a lock. one slot is always left
+//   empty so that head == tail can only mean "nothing to write".
+//   the disk side is asynchronous: idle time only starts a PBWrite, and its
+//   completion routine (interrupt time) moves tail once the records are on
+//   disk, and chains the next write for the rest of the flush. as with
+//   telemetry, in_flight is only set true when no write is pending, and only
+//   the completion routine sets it back to false.
+//   playback uses the same ring the other way round: a read fills it from
+//   slot 0 (the completion routine sets head), and idle time posts from tail.
+static EventRecord*			cursors_journal_ring = NULL;
+static volatile uint16_t	cursors_journal_head = 0;	// next slot to fill
+static volatile uint16_t	cursors_journal_tail = 0;	// next slot to write to disk
+static volatile uint16_t	cursors_journal_flush_end = 0;	// head when this flush started
+static volatile int32_t		cursors_journal_last_when = 0;	// ticks of last recorded key
+static volatile bool		cursors_journal_in_flight = false;
+static volatile OSErr		cursors_journal_write_err = noErr;	// first failed write, for idle to act on
+static volatile bool		cursors_journal_play_eof = false;	// last playback batch read
+static uint16_t				cursors_journal_sending;	// records in the write in flight
+static bool					cursors_journal_has_idle;	// CursorsJournalIdle() gets called
+
+static ParamBlockRec		cursors_journal_pb;
+static int16_t				cursors_journal_vrefnum;	// System Folder
+static int16_t				cursors_journal_refnum;		// journal file, open while recording or stopping
+static int16_t				cursors_journal_play_refnum;	// open journal file during playback
+static uint8_t				cursors_journal_name[] = "\pCustom Cursors Journal";
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+uint8_t		cursors_journal_state = JOURNAL_OFF;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Writes the next contiguous run of records up to flush_end, asynchronously,
+//  or marks the file idle if there is none
+static void CursorsJournalStartWrite(void);
+
+// Reads the next batch of the journal file into the ring, asynchronously
+static void CursorsJournalStartRead(void);
+
+// Writes everything between tail and head to the journal file, and waits.
+//  Application time only: used when recording stops
+// @return	Returns noErr or a File Manager error
+static OSErr CursorsJournalFlushNow(void);
+
+// Closes the journal file once recording is over, and turns the journal off
+static void CursorsJournalClose(void);
+
+// Posts the next event from the ring, or reads the next batch into it. Stops
+//  playback at end of file
+static void CursorsJournalPlayNext(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Writes the next contiguous run of records up to flush_end, asynchronously,
+//  or marks the file idle if there is none
+static void CursorsJournalStartWrite(void)
+{
+	uint16_t	flush_end;
+	uint16_t	tail;
+
+	flush_end = cursors_journal_flush_end;
+	tail = cursors_journal_tail;
+
+	if (flush_end == tail)
+	{
+		cursors_journal_in_flight = false;
+		return;
+	}
+
+	// if the ring wrapped, write up to the end now; the rest goes next write
+	cursors_journal_sending = (flush_end > tail) ? (flush_end - tail) : (JOURNAL_RING_SIZE - tail);
+
+	cursors_journal_pb.ioParam.ioBuffer = (Ptr)&cursors_journal_ring[tail];
+	cursors_journal_pb.ioParam.ioReqCount = cursors_journal_sending * sizeof(EventRecord);
+	cursors_journal_pb.ioParam.ioPosMode = fsAtMark;
+	cursors_journal_pb.ioParam.ioPosOffset = 0;
+
+	cursors_journal_in_flight = true;
+
+	if (PBWrite(&cursors_journal_pb, true) != noErr)
+	{
+		// not even queued, so no completion routine will come
+		cursors_journal_write_err = cursors_journal_pb.ioParam.ioResult;
+		cursors_journal_in_flight = false;
+	}
+}
+
+
+// Reads the next batch of the journal file into the ring, asynchronously
+static void CursorsJournalStartRead(void);
+
+// Reads the next batch of the journal file into the ring, asynchronously
+static void CursorsJournalStartRead(void)
+{
+	cursors_journal_pb.ioParam.ioRefNum = cursors_journal_play_refnum;
+	cursors_journal_pb.ioParam.ioBuffer = (Ptr)cursors_journal_ring;
+	cursors_journal_pb.ioParam.ioReqCount = JOURNAL_FLUSH_COUNT * sizeof(EventRecord);
+	cursors_journal_pb.ioParam.ioPosMode = fsAtMark;
+	cursors_journal_pb.ioParam.ioPosOffset = 0;
+
+	cursors_journal_in_flight = true;
+
+	if (PBRead(&cursors_journal_pb, true) != noErr)
+	{
+		// not even queued: end playback at the next idle
+		cursors_journal_play_eof = true;
+		cursors_journal_in_flight = false;
+	}
+}
+
+
+// Writes everything between tail and head to the journal file, and waits.
+//  Application time only: used when recording stops
+// @return	Returns noErr or a File Manager error
+static OSErr CursorsJournalFlushNow(void)
+{
+	int32_t		count;
+	uint16_t	head;
+	uint16_t	tail;
+	OSErr		the_err = noErr;
+
+	head = cursors_journal_head;
+	tail = cursors_journal_tail;
+
+	if (head < tail)
+	{
+		count = (JOURNAL_RING_SIZE - tail) * sizeof(EventRecord);
+		the_err = FSWrite(cursors_journal_refnum, &count, (Ptr)&cursors_journal_ring[tail]);
+		tail = 0;
+	}
+
+	if (the_err == noErr && head > tail)
+	{
+		count = (head - tail) * sizeof(EventRecord);
+		the_err = FSWrite(cursors_journal_refnum, &count, (Ptr)&cursors_journal_ring[tail]);
+		tail = head;
+	}
+
+	if (the_err == noErr)
+	{
+		cursors_journal_tail = tail;
+	}
+
+	return the_err;
+}
+
+
+// Closes the journal file once recording is over, and turns the journal off
+static void CursorsJournalClose(void)
+{
+	FSClose(cursors_journal_refnum);
+	cursors_journal_state = JOURNAL_OFF;
+}
+
+
+// Posts the next event from the ring, or reads the next batch into it. Stops
+//  playback at end of file
+static void CursorsJournalPlayNext(void)
+{
+	EventRecord*	the_event;
+	EvQElPtr		the_q_el;
+
+	if (cursors_journal_in_flight)
+	{
+		return;
+	}
+
+	if (cursors_journal_tail == cursors_journal_head)
+	{
+		if (cursors_journal_play_eof)
+		{
+			FSClose(cursors_journal_play_refnum);
+			cursors_journal_state = JOURNAL_OFF;
+		}
+		else
+		{
+			CursorsJournalStartRead();
+		}
+
+		return;
+	}
+
+	the_event = &cursors_journal_ring[cursors_journal_tail++];
+
+	// PPostEvent hands back the queue element, so the original modifiers
+	//  (shift-cursor etc.) can go back on the event
+	if (PPostEvent(the_event->what, the_event->message, &the_q_el) == noErr)
+	{
+		the_q_el->evtQModifiers = the_event->modifiers;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+
+// **** CONSTRUCTOR AND DESTRUCTOR *****
+
+// Preallocates the ring buffer in the system heap. Called once, from main()
+// @param	vRefNum: the System Folder, where the journal file lives
+// @param	completion_proc: the read / write completion routine. It must set
+//			up A4 and then call CursorsJournalIODone()
+// @param	has_idle: true if CursorsJournalIdle() will be called, that is, if
+//			we run the dispatcher. If not, the caller calls
+//			CursorsJournalDrain() after each append instead
+// @return	Returns noErr, or memFullErr if the ring could not be allocated
+OSErr CursorsJournalInit(int16_t vRefNum, ProcPtr completion_proc, bool has_idle)
+{
+	cursors_journal_vrefnum = vRefNum;
+	cursors_journal_has_idle = has_idle;
+	cursors_journal_pb.ioParam.ioCompletion = completion_proc;
+	cursors_journal_ring = (EventRecord*)NewPtrSys(JOURNAL_RING_SIZE * sizeof(EventRecord));
+
+	if (cursors_journal_ring == NULL)
+	{
+		return memFullErr;
+	}
+
+	return noErr;
+}
+
+
+
+// **** SETTERS *****
+
+
+
+// **** GETTERS *****
+
+
+
+// **** OTHER FUNCTIONS *****
+
+// Copies one delivered key event into the ring. Event path: no Memory
+//  Manager or File Manager calls. If the ring is full, the event is dropped
+void CursorsJournalAppend(const EventRecord *theEvent)
+{
+	uint16_t	next_head;
+
+	next_head = (cursors_journal_head + 1) & JOURNAL_RING_MASK;
+
+	if (next_head == cursors_journal_tail)
+	{
+		// never wait on the disk here. losing a keystroke from the journal
+		//  beats adding latency to the keystroke itself
+		return;
+	}
+
+	cursors_journal_ring[cursors_journal_head] = *theEvent;
+	cursors_journal_last_when = theEvent->when;
+
+	// publish the slot only after it is fully written
+	cursors_journal_head = next_head;
+}
+
+
+// Starts writing recorded events out once the ring is half full. For when
+//  there is no idle time: called on the key path, after CursorsJournalAppend()
+void CursorsJournalDrain(void)
+{
+	// a failed write stays failed: stopping reports it
+	if (cursors_journal_in_flight || cursors_journal_write_err != noErr)
+	{
+		return;
+	}
+
+	if (((cursors_journal_head - cursors_journal_tail) & JOURNAL_RING_MASK) >= JOURNAL_FLUSH_COUNT)
+	{
+		// anything recorded from here on goes in the next flush
+		cursors_journal_flush_end = cursors_journal_head;
+		CursorsJournalStartWrite();
+	}
+}
+
+
+// Does the deferred work: starts writing recorded events out to the journal
+//  file once typing pauses, or posts the next event during playback, reading
+//  the next batch when the ring runs dry. Called from GetNextEvent when there
+//  is no event to deliver. Only starts reads and writes; the one wait on the
+//  disk is the FSClose once a recording or a playback is over
+void CursorsJournalIdle(void)
+{
+	uint16_t	pending;
+
+	if (cursors_journal_state == JOURNAL_PLAYING)
+	{
+		CursorsJournalPlayNext();
+		return;
+	}
+
+	if (cursors_journal_in_flight)
+	{
+		return;
+	}
+
+	if (cursors_journal_write_err != noErr)
+	{
+		// disk full, locked, ejected... stop rather than retry on every idle
+		CursorsJournalClose();
+		return;
+	}
+
+	pending = (cursors_journal_head - cursors_journal_tail) & JOURNAL_RING_MASK;
+
+	if (cursors_journal_state == JOURNAL_STOPPING && pending == 0)
+	{
+		// the last of the recording is on disk
+		CursorsJournalClose();
+		return;
+	}
+
+	if (pending == 0)
+	{
+		return;
+	}
+
+	if (cursors_journal_state == JOURNAL_STOPPING || pending >= JOURNAL_FLUSH_COUNT || TickCount() - cursors_journal_last_when >= JOURNAL_FLUSH_TICKS)
+	{
+		// anything recorded from here on goes in the next flush
+		cursors_journal_flush_end = cursors_journal_head;
+		CursorsJournalStartWrite();
+	}
+}
+
+
+// Completion of one async read or write. A write frees the slots written and
+//  chains the write of the rest of the flush, if the ring wrapped. A playback
+//  read hands the batch it read to idle time. Interrupt time
+void CursorsJournalIODone(void)
+{
+	if (cursors_journal_state == JOURNAL_PLAYING)
+	{
+		// a short read (eofErr) still hands over what it got
+		cursors_journal_tail = 0;
+		cursors_journal_head = cursors_journal_pb.ioParam.ioActCount / sizeof(EventRecord);
+
+		if (cursors_journal_pb.ioParam.ioResult != noErr || cursors_journal_head < JOURNAL_FLUSH_COUNT)
+		{
+			cursors_journal_play_eof = true;
+		}
+
+		cursors_journal_in_flight = false;
+		return;
+	}
+
+	if (cursors_journal_pb.ioParam.ioResult != noErr)
+	{
+		// keep the slots: idle time closes the file and stops recording
+		cursors_journal_write_err = cursors_journal_pb.ioParam.ioResult;
+		cursors_journal_in_flight = false;
+		return;
+	}
+
+	// only give the slots back to the event path once they are safely on disk
+	cursors_journal_tail = (cursors_journal_tail + cursors_journal_sending) & JOURNAL_RING_MASK;
+
+	CursorsJournalStartWrite();
+}
+
+
+// Empties the journal file and starts recording
+// @return	Returns noErr, a File Manager error, or CURSORS_JOURNAL_ERR_xxx
+OSErr CursorsJournalStartRecording(void)
+{
+	int16_t		refnum;
+	OSErr		the_err;
+
+	if (cursors_journal_ring == NULL)
+	{
+		return CURSORS_JOURNAL_ERR_NO_RING;
+	}
+
+	if (cursors_journal_state != JOURNAL_OFF)
+	{
+		return CURSORS_JOURNAL_ERR_BUSY;
+	}
+
+	the_err = Create(cursors_journal_name, cursors_journal_vrefnum, JOURNAL_FILE_CREATOR, JOURNAL_FILE_TYPE);
+
+	if (the_err != noErr && the_err != dupFNErr)
+	{
+		return the_err;
+	}
+
+	// LOGIC:
+	//   the file stays open until recording stops, so that idle time only
+	//   ever has to start a write, which is queued and returns at once. writes
+	//   go at the mark, which SetEOF leaves at 0 and each write moves on.
+
+	the_err = FSOpen(cursors_journal_name, cursors_journal_vrefnum, &refnum);
+
+	if (the_err != noErr)
+	{
+		return the_err;
+	}
+
+	the_err = SetEOF(refnum, 0);
+
+	if (the_err != noErr)
+	{
+		FSClose(refnum);
+		return the_err;
+	}
+
+	cursors_journal_refnum = refnum;
+	cursors_journal_pb.ioParam.ioRefNum = refnum;
+	cursors_journal_write_err = noErr;
+	cursors_journal_head = 0;
+	cursors_journal_tail = 0;
+	cursors_journal_state = JOURNAL_RECORDING;
+
+	return noErr;
+}
+
+
+// Stops recording and writes out anything still in the ring. If a write is
+//  still in flight, idle time writes the rest and closes the file. Without
+//  idle time, this waits for the write, then writes the rest itself
+// @return	Returns noErr or a File Manager error
+OSErr CursorsJournalStopRecording(void)
+{
+	OSErr		the_err;
+
+	if (cursors_journal_state != JOURNAL_RECORDING)
+	{
+		return noErr;
+	}
+
+	// no more appends from here on
+	cursors_journal_state = JOURNAL_STOPPING;
+
+	if (cursors_journal_in_flight && cursors_journal_has_idle)
+	{
+		return noErr;
+	}
+
+	// application time, so the write can be waited for: its completion
+	//  routine runs at interrupt time, and chains the rest of its flush
+	while (cursors_journal_in_flight)
+	{
+	}
+
+	// application time, and nothing queued on the file: just write and close
+	the_err = cursors_journal_write_err;
+
+	if (the_err == noErr)
+	{
+		the_err = CursorsJournalFlushNow();
+	}
+
+	CursorsJournalClose();
+
+	return the_err;
+}
+
+
+// Starts posting the events in the journal file, one per idle call
+// @return	Returns noErr, a File Manager error, or CURSORS_JOURNAL_ERR_xxx
+OSErr CursorsJournalStartPlayback(void)
+{
+	OSErr		the_err;
+
+	if (cursors_journal_ring == NULL)
+	{
+		return CURSORS_JOURNAL_ERR_NO_RING;
+	}
+
+	if (cursors_journal_state != JOURNAL_OFF)
+	{
+		return CURSORS_JOURNAL_ERR_BUSY;
+	}
+
+	// events are only posted from idle time
+	if (!cursors_journal_has_idle)
+	{
+		return CURSORS_JOURNAL_ERR_NO_IDLE;
+	}
+
+	the_err = FSOpen(cursors_journal_name, cursors_journal_vrefnum, &cursors_journal_play_refnum);
+
+	if (the_err == noErr)
+	{
+		// the first idle reads the first batch
+		cursors_journal_head = 0;
+		cursors_journal_tail = 0;
+		cursors_journal_play_eof = false;
+		cursors_journal_state = JOURNAL_PLAYING;
+	}
+
+	return the_err;
+}
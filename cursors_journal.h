@@ -0,0 +1,159 @@
+/*
+ * cursors_journal.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Keystroke journal: records the key events Custom Cursors delivers, and can
+ *  play them back later as a macro.
+ *
+ * A companion app (or FKEY) gets the control interface through Gestalt:
+ *   if (Gestalt(CURSORS_JOURNAL_SELECTOR, &response) == noErr)
+ *   {
+ *     journal_if = (CursorsJournalInterface*)response;
+ *     err = (*journal_if->start_recording)();
+ *   }
+ *
+ * While recording, the event path only copies each delivered key event into
+ *  a ring buffer that was allocated in the system heap at boot. Nothing is
+ *  written to disk until the user stops typing for a moment (or the ring is
+ *  getting full). Then GetNextEvent's idle (no event) path starts an
+ *  asynchronous write to the journal file, which stays open while recording,
+ *  and returns at once; the write's completion routine frees the ring slots.
+ *  Playback reads the file into the same ring, a batch at a time, with
+ *  asynchronous reads started from idle time too. GetNextEvent only waits on
+ *  the disk for the FSClose at the end of a recording or a playback.
+ *
+ * When Custom Cursors joined another INIT's dispatcher, it gets key events
+ *  but no idle time. Then the key path starts the write once the ring is half
+ *  full, stopping waits for the last write, and playback is not available.
+ *
+ * The journal file ("Custom Cursors Journal" in the System Folder) is a plain
+ *  array of EventRecords, in 68k byte order, with no header. Host-side tools
+ *  can read and replay it as is.
+ *
+ * All functions here expect A4 to already be set up by the caller.
+ */
+
+#ifndef CURSORS_JOURNAL_H_
+#define CURSORS_JOURNAL_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+#include <Types.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define CURSORS_JOURNAL_SELECTOR		'CCjr'	// Gestalt selector; response is a CursorsJournalInterface*
+#define CURSORS_JOURNAL_VERSION			2		// bump if CursorsJournalInterface layout changes (2: error codes now positive)
+
+#define CURSORS_JOURNAL_ERR_NO_RING		2		// ring buffer could not be allocated at boot
+#define CURSORS_JOURNAL_ERR_BUSY		3		// already recording or playing back
+												//  positive, like CURSORS_KEYMAP_ERR_BUSY: -2 and -3
+												//  are vTypErr and corErr, which FSOpen etc. return too
+#define CURSORS_JOURNAL_ERR_NO_IDLE		4		// playback needs idle time, which an INIT that
+												//  joined another's dispatcher does not get
+
+#define JOURNAL_OFF						0
+#define JOURNAL_RECORDING				1
+#define JOURNAL_PLAYING					2
+#define JOURNAL_STOPPING				3		// recording stopped, last writes still going out
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+// @return	Returns noErr, a File Manager error, or CURSORS_JOURNAL_ERR_xxx
+typedef pascal OSErr (*CursorsJournalProcPtr)(void);
+
+typedef struct CursorsJournalInterface
+{
+	int16_t					version;
+	int16_t					reserved;
+	CursorsJournalProcPtr	start_recording;	// empties the journal file and starts capturing
+	CursorsJournalProcPtr	stop_recording;		// stops capturing, writes out whatever is left
+	CursorsJournalProcPtr	start_playback;		// posts the journal file's events, one per idle
+} CursorsJournalInterface;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// JOURNAL_OFF, JOURNAL_RECORDING, JOURNAL_PLAYING or JOURNAL_STOPPING. Read on the event path
+//  so callers can skip the function call entirely while journaling is off
+extern uint8_t	cursors_journal_state;
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// Preallocates the ring buffer in the system heap. Called once, from main()
+// @param	vRefNum: the System Folder, where the journal file lives
+// @param	completion_proc: the read / write completion routine. It must set
+//			up A4 and then call CursorsJournalIODone()
+// @param	has_idle: true if CursorsJournalIdle() will be called, that is, if
+//			we run the dispatcher. If not, the caller calls
+//			CursorsJournalDrain() after each append instead
+// @return	Returns noErr, or memFullErr if the ring could not be allocated
+OSErr CursorsJournalInit(int16_t vRefNum, ProcPtr completion_proc, bool has_idle);
+
+// Copies one delivered key event into the ring. Event path: no Memory
+//  Manager or File Manager calls. If the ring is full, the event is dropped
+void CursorsJournalAppend(const EventRecord *theEvent);
+
+// Starts writing recorded events out once the ring is half full. For when
+//  there is no idle time: called on the key path, after CursorsJournalAppend()
+void CursorsJournalDrain(void);
+
+// Does the deferred work: starts writing recorded events out to the journal
+//  file once typing pauses, or posts the next event during playback, reading
+//  the next batch when the ring runs dry. Called from GetNextEvent when there
+//  is no event to deliver. Only starts reads and writes; the one wait on the
+//  disk is the FSClose once a recording or a playback is over
+void CursorsJournalIdle(void);
+
+// Completion of one async read or write. A write frees the slots written and
+//  chains the write of the rest of the flush, if the ring wrapped. A playback
+//  read hands the batch it read to idle time. Interrupt time
+void CursorsJournalIODone(void);
+
+// Empties the journal file and starts recording
+// @return	Returns noErr, a File Manager error, or CURSORS_JOURNAL_ERR_xxx
+//			(ERR_BUSY also while the last recording is still being written out)
+OSErr CursorsJournalStartRecording(void);
+
+// Stops recording and writes out anything still in the ring. If a write is
+//  still in flight, idle time writes the rest and closes the file. Without
+//  idle time, this waits for the write, then writes the rest itself
+// @return	Returns noErr or a File Manager error
+OSErr CursorsJournalStopRecording(void);
+
+// Starts posting the events in the journal file, one per idle call
+// @return	Returns noErr, a File Manager error, or CURSORS_JOURNAL_ERR_xxx
+OSErr CursorsJournalStartPlayback(void);
+
+
+#endif /* CURSORS_JOURNAL_H_ */
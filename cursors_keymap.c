@@ -0,0 +1,167 @@
+/*
+ * cursors_keymap.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Double-buffered keymap tables for Custom Cursors: publishing a new mapping
+ *  without locks, and pinning the current one on the event path.
+ *  See cursors_keymap.h.
+ *
+ * Note: this file must NOT include SetUpA4.h, and must not use globals, so
+ *  that it can run anywhere, with or without A4 set up. The host tools
+ *  (tools/) build it as is.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Types.h>
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+
+// **** CONSTRUCTOR AND DESTRUCTOR *****
+
+// Puts the starting mapping in the first table and publishes it. INIT time
+// @param	tables: the tables to set up
+// @param	initial_map: the mapping to start with
+void CursorsKeymapInit(CursorsKeymapTables *tables, const CursorsKeymap *initial_map)
+{
+	tables->table[0] = *initial_map;
+	tables->in_use = NULL;
+	tables->busy = false;
+	tables->active = &tables->table[0];
+}
+
+
+
+// **** SETTERS *****
+
+// Builds a new mapping into the inactive table and publishes it.
+//   Safe at application time and at interrupt time. A call that overlaps
+//   another set or get (one interrupted the other) returns CURSORS_KEYMAP_ERR_BUSY
+// @param	tables: the tables to update
+// @param	new_map: the mapping to publish
+// @return	Returns noErr, paramErr if the mapping is invalid, or CURSORS_KEYMAP_ERR_BUSY
+OSErr CursorsKeymapSet(CursorsKeymapTables *tables, const CursorsKeymap *new_map)
+{
+	CursorsKeymap*	spare_map;
+
+	// LOGIC:
+	//   two setters must never write the spare table at the same time: if an
+	//   interrupt-time set landed in the middle of an application-time one,
+	//   both would pick the same spare, the interrupt would publish it, and the
+	//   interrupted one would go on writing into the now active table.
+	//   so the first thing a setter does is claim 'busy'. on a 68000 there is
+	//   only one CPU, and an interrupt runs to completion before the code it
+	//   interrupted goes on, so a plain test then set is enough:
+	//     interrupted before the set: the interrupt's whole call runs and
+	//       clears busy again, and we pick the spare only after claiming it,
+	//       so we see its result
+	//     interrupted after the set: the interrupt's call sees busy and backs off
+	//   the spare is also skipped while the event path still reads it (in_use)
+
+	if (new_map->modifier_choice > MODIFIER_CAPSLOCK_MODE_2)
+	{
+		return paramErr;
+	}
+
+	if (tables->busy)
+	{
+		return CURSORS_KEYMAP_ERR_BUSY;
+	}
+
+	tables->busy = true;
+
+	spare_map = (tables->active == &tables->table[0]) ? &tables->table[1] : &tables->table[0];
+
+	if (spare_map == tables->in_use)
+	{
+		// we interrupted the event path right after a previous swap, and it is
+		//  still reading the table we would overwrite. caller can just retry.
+		tables->busy = false;
+		return CURSORS_KEYMAP_ERR_BUSY;
+	}
+
+	*spare_map = *new_map;
+
+	// the one and only store that makes the new table visible
+	tables->active = spare_map;
+	tables->busy = false;
+
+	return noErr;
+}
+
+
+
+// **** GETTERS *****
+
+// Copies the currently active mapping. Same rules as CursorsKeymapSet()
+// @param	tables: the tables to read
+// @param	current_map: receives a copy of the active mapping
+// @return	Returns noErr, or CURSORS_KEYMAP_ERR_BUSY if it interrupted a set or get
+OSErr CursorsKeymapGet(CursorsKeymapTables *tables, CursorsKeymap *current_map)
+{
+	// holding busy keeps a setter (at interrupt time) from reusing the table
+	//  we are copying: one set would only write the spare, but a second
+	//  would write this one
+	if (tables->busy)
+	{
+		return CURSORS_KEYMAP_ERR_BUSY;
+	}
+
+	tables->busy = true;
+	*current_map = *tables->active;
+	tables->busy = false;
+
+	return noErr;
+}
+
+
+// Event path: marks the active table as in use and returns it. The table
+//   stays unchanged until CursorsKeymapUnpin(). Never fails, never waits
+// @param	tables: the tables to read
+// @return	Returns the table to read the mapping from
+const CursorsKeymap* CursorsKeymapPin(CursorsKeymapTables *tables)
+{
+	CursorsKeymap*	map;
+
+	// LOGIC:
+	//   grab the active table once and mark it in use, then make sure it was
+	//   not swapped in between. everything after reads only through 'map'.
+
+	do
+	{
+		map = tables->active;
+		tables->in_use = map;
+	} while (map != tables->active);
+
+	return map;
+}
+
+
+// Event path: done reading the table returned by CursorsKeymapPin()
+// @param	tables: the tables to release
+void CursorsKeymapUnpin(CursorsKeymapTables *tables)
+{
+	tables->in_use = NULL;
+}
@@ -0,0 +1,142 @@
+/*
+ * cursors_keymap.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Public interface for changing the Custom Cursors key mapping at runtime,
+ *  without ResEdit and without a restart.
+ *
+ * A companion app (or FKEY, cdev, etc.) gets the interface through Gestalt:
+ *   if (Gestalt(CURSORS_KEYMAP_SELECTOR, &response) == noErr)
+ *   {
+ *     keymap_if = (CursorsKeymapInterface*)response;
+ *     (*keymap_if->get_keymap)(&the_map);
+ *     the_map.modifier_choice = 0;
+ *     err = (*keymap_if->set_keymap)(&the_map);
+ *   }
+ *
+ * The INIT keeps two tables (CursorsKeymapTables, cursors_keymap.c).
+ *  set_keymap() builds the new mapping into the table that is not in use,
+ *  then publishes it with a single pointer store, so the event path never
+ *  takes a lock and never sees a half-written table.
+ *
+ * set_keymap() and get_keymap() can be called at application time or at
+ *  interrupt time. If one call interrupts another (say a VBL task calls
+ *  set_keymap while the app is in the middle of one), the interrupting call
+ *  returns CURSORS_KEYMAP_ERR_BUSY and changes nothing; try again later.
+ */
+
+#ifndef CURSORS_KEYMAP_H_
+#define CURSORS_KEYMAP_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Types.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define CURSORS_KEYMAP_SELECTOR		'CCmp'	// Gestalt selector; response is a CursorsKeymapInterface*
+#define CURSORS_KEYMAP_VERSION		2		// bump if CursorsKeymapInterface or CursorsKeymap layout changes (2: get_keymap returns OSErr)
+
+#define CURSORS_NUM_KEYS			4		// up, left, down, right
+
+#define CURSORS_KEYMAP_ERR_BUSY		1		// overlapped another call, or event path still reads the spare table.
+											//  positive: outside the system's (negative) error codes
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+// same meaning as the ResEdit-editable bytes in the INIT, see custom_cursors.c
+typedef struct CursorsKeymap
+{
+	uint8_t		key[CURSORS_NUM_KEYS];		// 1-byte key codes to remap (IM I-251)
+	uint8_t		modifier_choice;			// 0 = option, 1 = capslock, 2 = capslock w/o uppercase
+	uint8_t		reserved;
+	uint16_t	remap[CURSORS_NUM_KEYS];	// key code in hi byte, char code in lo byte
+} CursorsKeymap;
+
+// @return	Returns noErr, paramErr if the mapping is invalid, or CURSORS_KEYMAP_ERR_BUSY
+typedef pascal OSErr (*CursorsSetKeymapProcPtr)(const CursorsKeymap *new_map);
+// @return	Returns noErr, or CURSORS_KEYMAP_ERR_BUSY (current_map left alone)
+typedef pascal OSErr (*CursorsGetKeymapProcPtr)(CursorsKeymap *current_map);
+
+typedef struct CursorsKeymapInterface
+{
+	int16_t					version;
+	int16_t					reserved;
+	CursorsSetKeymapProcPtr	set_keymap;
+	CursorsGetKeymapProcPtr	get_keymap;
+} CursorsKeymapInterface;
+
+// the INIT's side of the interface: the two tables and who is using them
+typedef struct CursorsKeymapTables
+{
+	CursorsKeymap				table[2];
+	CursorsKeymap* volatile		active;		// the published table
+	CursorsKeymap* volatile		in_use;		// table the event path is reading, or NULL
+	volatile bool				busy;		// a set or get is in progress
+} CursorsKeymapTables;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// Puts the starting mapping in the first table and publishes it. INIT time
+// @param	tables: the tables to set up
+// @param	initial_map: the mapping to start with
+void CursorsKeymapInit(CursorsKeymapTables *tables, const CursorsKeymap *initial_map);
+
+// Builds a new mapping into the inactive table and publishes it.
+//   Safe at application time and at interrupt time. A call that overlaps
+//   another set or get (one interrupted the other) returns CURSORS_KEYMAP_ERR_BUSY
+// @param	tables: the tables to update
+// @param	new_map: the mapping to publish
+// @return	Returns noErr, paramErr if the mapping is invalid, or CURSORS_KEYMAP_ERR_BUSY
+OSErr CursorsKeymapSet(CursorsKeymapTables *tables, const CursorsKeymap *new_map);
+
+// Copies the currently active mapping. Same rules as CursorsKeymapSet()
+// @param	tables: the tables to read
+// @param	current_map: receives a copy of the active mapping
+// @return	Returns noErr, or CURSORS_KEYMAP_ERR_BUSY if it interrupted a set or get
+OSErr CursorsKeymapGet(CursorsKeymapTables *tables, CursorsKeymap *current_map);
+
+// Event path: marks the active table as in use and returns it. The table
+//   stays unchanged until CursorsKeymapUnpin(). Never fails, never waits
+// @param	tables: the tables to read
+// @return	Returns the table to read the mapping from
+const CursorsKeymap* CursorsKeymapPin(CursorsKeymapTables *tables);
+
+// Event path: done reading the table returned by CursorsKeymapPin()
+// @param	tables: the tables to release
+void CursorsKeymapUnpin(CursorsKeymapTables *tables);
+
+
+#endif /* CURSORS_KEYMAP_H_ */
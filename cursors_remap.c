@@ -0,0 +1,174 @@
+/*
+ * cursors_remap.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Remap core for Custom Cursors. See cursors_remap.h.
+ *
+ * Note: this file must NOT include SetUpA4.h, and must not use globals, so
+ *  that it can run anywhere, with or without A4 set up.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_remap.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+// Intercept key events for our specified key combinations and modify them to
+// be cursor keys instead. For any other combo, pass thru keys without mod.
+//   Modifies EventRecord.message (and modifiers) if appropriate
+// @param	theEvent: a keyDown or autoKey event
+// @param	map: the key mapping to apply
+// @param	state: repeat tracking for this instance; updated
+void CursorsRemapEvent(EventRecord *theEvent, const CursorsKeymap *map, CursorsRemapState *state)
+{
+	uint8_t		the_key;
+	uint8_t		the_char;	// needed for unshifting in capslock modes
+	int16_t		i;
+	uint32_t	modified_code_and_char = 0;
+	bool		is_repeat_of_last;
+	bool		do_remap;
+	bool		modifier_down = false;
+
+	// LOGIC:
+	//   inspect modifier. if not the chosen modifier, and not a repeat, return
+	//   inspect the key. If [, ], \, or =, translate to a cursor key
+	//   before returning, remove option key from the modifiers, but do not clear them. 
+	//     this allows SHIFT-cursor-right etc.
+	
+	// determine if selected modifier is down, then do universal check for the key
+	// can't return even if modifier not down until we check for key repeat
+	// key repeat events do not include the modifier key info!
+	
+	switch(map->modifier_choice)
+	{
+		case MODIFIER_CAPSLOCK_MODE_1:
+		case MODIFIER_CAPSLOCK_MODE_2:
+			modifier_down = ((theEvent->modifiers & alphaLock) > 0);
+			break;
+		
+		case MODIFIER_OPT_KEY:
+			modifier_down = ((theEvent->modifiers & optionKey) > 0);
+			break;
+		
+		default:
+			// modifier not down (modifier_down starts false), but need to check
+			//  if this is a repeat event before giving up
+			break;
+	}
+	
+	// LOGIC:
+	//   do remapping if:
+	//     (the modifier is down AND a specified key is down) OR
+	//     (it is a key repeat event AND the repeat key matches one 
+	//         of our keys AND we previously set flag that we are 
+	//         remapping)
+	
+	the_key = (theEvent->message & keyCodeMask) >> 8;
+	the_char = theEvent->message & charCodeMask;
+	is_repeat_of_last = (the_key == state->last_remapped_key && state->last_event_was_remap);
+	do_remap = ((modifier_down || is_repeat_of_last) > 0);
+	
+	if (do_remap == true)
+    {
+		// LOGIC:
+		//   we have array for key to map (1 byte)
+		//   and array for key to map to (2 bytes)
+		//   same offsets used for both, so no need to different 
+		//   code per key (all are co-equal and get same simple swap)
+		
+		for (i = 0; i < CURSORS_NUM_KEYS; i++)
+		{
+			if (the_key == map->key[i])
+			{
+				modified_code_and_char = map->remap[i];
+			}
+		}
+	
+		if (modified_code_and_char)
+		{
+			// re-mask by blanking out lower 2 bytes, preserving 3rd/4th byte
+			theEvent->message = (theEvent->message & 0xFFFF0000) | modified_code_and_char;
+
+			// different behavior depending on modifier choice
+			// note that MODIFIER_CAPSLOCK_MODE_2 is handled further down
+			//  because it applies even if not working with a remap key
+			
+			if (map->modifier_choice == MODIFIER_OPT_KEY)
+			{
+				// clear the option modifier only, leaving any shift, control, etc.
+				// this means that essentially, you can't do option [, ], = or \. boohoo.					
+				theEvent->modifiers &= ~(OPT_KEY_MASK);
+			}
+			else if (map->modifier_choice == MODIFIER_CAPSLOCK_MODE_1)
+			{
+				// clear the capslock modifier only, leaving any shift, control, option, etc.
+				theEvent->modifiers &= ~(alphaLock);
+				
+				// LOGIC:
+				//   it is not necessary for us to remap upper to lower
+				//   for capslock mode 1 because wee already remapped THIS key
+				//   to a cursor key. Capsmode 2 below will remap chars to lower if necessar.
+			}					
+
+			state->last_remapped_key = the_key;
+			state->last_event_was_remap = true;
+		}
+	}
+	else
+	{
+		state->last_event_was_remap = false;
+	}
+	
+	// for capslock mode 2 only: ALWAYS neutralize capslock on key down
+	// even if for keys we aren't mapping. The goal is to let the user
+	// just leave the capslock on permanently, and have cursors, but other-
+	// wise totally normal key behavior. Obviously, not good for IJKL, but
+	// good if you have a numpad and map to 8456 or 5123 etc.
+	if (map->modifier_choice == MODIFIER_CAPSLOCK_MODE_2)
+	{
+		// clear the capslock modifier only, leaving any shift, control, option, etc.
+		// this means there is no capslock-like behavior				
+		theEvent->modifiers &= ~(alphaLock);
+
+		// LOGIC: 
+		//   The above will not actually accomplish much, other than
+		//   letting any program testing for CapsLock know it isn't
+		//   supposed to be on. The reason is that the keys have already been
+		//   shifted by this point. Next thing we do is unshift alpha keys.
+		//   note that we don't want to prevent caps if shift down
+		//   an event we just remapped already carries its new char (e.g. 1E
+		//   for up), so it is left alone: with a letter layout (WASD, IJKL)
+		//   the_char is the letter typed, and writing it back lowercased
+		//   would turn the cursor key back into 'w'.
+		
+		if (!modified_code_and_char && the_char >= 'A' & the_char <= 'Z')
+		{
+			if ((theEvent->modifiers & shiftKey) < 1)
+			{
+				the_char += 32;	// diff between upper and lower in Mac ASCII
+				theEvent->message = (theEvent->message & ~charCodeMask) | the_char;
+			}
+		}
+	}
+}
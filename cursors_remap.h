@@ -0,0 +1,84 @@
+/*
+ * cursors_remap.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Remap core: the part of Custom Cursors that actually turns a key event into
+ *  a cursor key. It touches nothing but the EventRecord, the keymap, and the
+ *  repeat-tracking state it is handed: no globals, no A4, no Toolbox calls.
+ *  The INIT keeps one CursorsRemapState; anything else (a test harness, a
+ *  replay tool) can run as many independent instances as it wants, each with
+ *  its own state and keymap.
+ */
+
+#ifndef CURSORS_REMAP_H_
+#define CURSORS_REMAP_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Events.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define OPT_KEY_MASK				0x0800	// 0b01010000 00000000 = bits for both right option 0x4000 and general options 0x0800
+
+#define MODIFIER_OPT_KEY			0	// Option key
+#define MODIFIER_CAPSLOCK_MODE_1	1	// CapsLock, keeping normal Caps behavior
+#define MODIFIER_CAPSLOCK_MODE_2	2	// CapsLock, neutralizing normal Caps behavior
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+// key repeat events do not carry the modifier, so remapping an autoKey
+//  depends on what happened to the keyDown before it
+typedef struct CursorsRemapState
+{
+	uint8_t		last_remapped_key;
+	bool		last_event_was_remap;
+} CursorsRemapState;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// Intercept key events for our specified key combinations and modify them to
+// be cursor keys instead. For any other combo, pass thru keys without mod.
+//   Modifies EventRecord.message (and modifiers) if appropriate
+// @param	theEvent: a keyDown or autoKey event
+// @param	map: the key mapping to apply
+// @param	state: repeat tracking for this instance; updated
+void CursorsRemapEvent(EventRecord *theEvent, const CursorsKeymap *map, CursorsRemapState *state);
+
+
+#endif /* CURSORS_REMAP_H_ */
@@ -206,6 +206,11 @@ static void DrawBWIcon (short iconID, Rect *iconRect)
 														// Then the icon.
 		source.baseAddr = *icon;
 		CopyBits(&source, &destination, &source.bounds, iconRect, srcOr, nil);
+		
+		// the original left the ICN# locked and loaded. Not a big deal for an
+		//  app, but at INIT time it is a locked block stuck in the system heap
+		HUnlock(icon);
+		ReleaseResource(icon);
 	}
 }
  
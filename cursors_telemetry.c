@@ -0,0 +1,278 @@
+/*
+ * cursors_telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Soak-test telemetry for Custom Cursors: remap decisions and counters out
+ *  the modem port through a ring buffer and async serial writes.
+ *  See cursors_telemetry.h.
+ *
+ * Note: this file must NOT include SetUpA4.h. In a multi-file THINK C code
+ *  resource, only custom_cursors.c can set up A4; every function here is
+ *  called from there with A4 already in place.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_telemetry.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Platform includes
+#include <Devices.h>
+#include <Events.h>
+#include <Files.h>
+#include <Serial.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TELEMETRY_RING_SIZE			64		// records (8 bytes each). must be a power of 2
+#define TELEMETRY_RING_MASK			(TELEMETRY_RING_SIZE - 1)
+#define TELEMETRY_COUNTER_TICKS		60		// send counters once a second, when idle
+
+#define TELEMETRY_SERIAL_CONFIG		(baud57600 + data8 + stop10 + noParity)
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// LOGIC:
+//   one producer (GetNextEvent, app time, moves head) and one consumer (the
+//   write completion routine, interrupt time, moves tail; so does a write
+//   that fails to start, with no completion pending). each side only ever
+//   writes its own index, so there is no lock. one slot is always left empty
+//   so head == tail can only mean "nothing to send".
+//   cursors_telemetry_in_flight is only set true when no write is pending, so
+//   the completion routine can't be running at the same time; only the
+//   completion routine sets it back to false, or the write that failed to
+//   start, which no completion routine will follow.
+static CursorsTelemetryRecord	cursors_telemetry_ring[TELEMETRY_RING_SIZE];
+static volatile uint16_t		cursors_telemetry_head = 0;
+static volatile uint16_t		cursors_telemetry_tail = 0;
+static volatile bool			cursors_telemetry_in_flight = false;
+static uint16_t					cursors_telemetry_sending;	// records in the write in flight
+static uint16_t					cursors_telemetry_seq = 0;
+static bool						cursors_telemetry_ready = false;
+
+static ParamBlockRec			cursors_telemetry_pb;
+static int16_t					cursors_telemetry_out_refnum;
+static int32_t					cursors_telemetry_next_counters = 0;	// TickCount() to send counters at
+
+static uint32_t					cursors_telemetry_keys_seen = 0;
+static uint32_t					cursors_telemetry_keys_remapped = 0;
+static uint32_t					cursors_telemetry_dropped = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Adds one record to the ring, or counts it as dropped if the ring is full
+static void CursorsTelemetryAppend(uint8_t kind, uint32_t data);
+
+// Sends the next contiguous run of records, or marks the port idle if none
+static void CursorsTelemetryStartWrite(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Adds one record to the ring, or counts it as dropped if the ring is full
+static void CursorsTelemetryAppend(uint8_t kind, uint32_t data)
+{
+	CursorsTelemetryRecord*	the_record;
+	uint16_t				next_head;
+
+	next_head = (cursors_telemetry_head + 1) & TELEMETRY_RING_MASK;
+
+	// seq always advances, so the collector can see where records went missing
+	cursors_telemetry_seq++;
+
+	if (next_head == cursors_telemetry_tail)
+	{
+		cursors_telemetry_dropped++;
+		return;
+	}
+
+	the_record = &cursors_telemetry_ring[cursors_telemetry_head];
+	the_record->sync = TELEMETRY_SYNC;
+	the_record->kind = kind;
+	the_record->seq = cursors_telemetry_seq;
+	the_record->data = data;
+
+	// publish the slot only after it is fully written
+	cursors_telemetry_head = next_head;
+}
+
+
+// Sends the next contiguous run of records, or marks the port idle if none
+static void CursorsTelemetryStartWrite(void)
+{
+	uint16_t	head;
+	uint16_t	tail;
+
+	head = cursors_telemetry_head;
+	tail = cursors_telemetry_tail;
+
+	if (head == tail)
+	{
+		cursors_telemetry_in_flight = false;
+		return;
+	}
+
+	// if the ring wrapped, send up to the end now; the rest goes next write
+	cursors_telemetry_sending = (head > tail) ? (head - tail) : (TELEMETRY_RING_SIZE - tail);
+
+	cursors_telemetry_pb.ioParam.ioBuffer = (Ptr)&cursors_telemetry_ring[tail];
+	cursors_telemetry_pb.ioParam.ioReqCount = cursors_telemetry_sending * sizeof(CursorsTelemetryRecord);
+	cursors_telemetry_pb.ioParam.ioPosMode = 0;
+
+	cursors_telemetry_in_flight = true;
+
+	if (PBWrite(&cursors_telemetry_pb, true) != noErr)
+	{
+		// not even queued, so no completion routine will come. drop what we
+		//  tried to send, as the completion would, and try again next idle
+		cursors_telemetry_tail = (tail + cursors_telemetry_sending) & TELEMETRY_RING_MASK;
+		cursors_telemetry_dropped += cursors_telemetry_sending;
+		cursors_telemetry_in_flight = false;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+
+// **** CONSTRUCTOR AND DESTRUCTOR *****
+
+// Opens and configures the modem port. Called once, from main()
+// @param	completion_proc: the write completion routine. It must set up A4
+//			and then call CursorsTelemetryWriteDone()
+// @return	Returns noErr or a Device Manager error; telemetry stays off on error
+OSErr CursorsTelemetryInit(ProcPtr completion_proc)
+{
+	int16_t		in_refnum;
+	OSErr		the_err;
+
+	// LOGIC:
+	//   the Serial Driver wants the input side opened before the output side,
+	//   even though we only ever write
+
+	the_err = OpenDriver("\p.AIn", &in_refnum);
+
+	if (the_err == noErr)
+	{
+		the_err = OpenDriver("\p.AOut", &cursors_telemetry_out_refnum);
+	}
+
+	if (the_err == noErr)
+	{
+		the_err = SerReset(cursors_telemetry_out_refnum, TELEMETRY_SERIAL_CONFIG);
+	}
+
+	if (the_err == noErr)
+	{
+		cursors_telemetry_pb.ioParam.ioCompletion = completion_proc;
+		cursors_telemetry_pb.ioParam.ioRefNum = cursors_telemetry_out_refnum;
+		cursors_telemetry_ready = true;
+	}
+
+	return the_err;
+}
+
+
+
+// **** SETTERS *****
+
+
+
+// **** GETTERS *****
+
+
+
+// **** OTHER FUNCTIONS *****
+
+// Records one remap decision and bumps the counters. Event path: only
+//  appends to the ring, never touches the port
+// @param	key_in: key code before remapping
+// @param	message_in: EventRecord.message before remapping
+// @param	message_out: EventRecord.message after remapping
+void CursorsTelemetryRemap(uint8_t key_in, int32_t message_in, int32_t message_out)
+{
+	uint8_t		flags = 0;
+
+	if (!cursors_telemetry_ready)
+	{
+		return;
+	}
+
+	cursors_telemetry_keys_seen++;
+
+	if (message_in != message_out)
+	{
+		flags |= TELEMETRY_FLAG_REMAPPED;
+		cursors_telemetry_keys_remapped++;
+	}
+
+	// key in, then key code and char out (low 16 bits of message), then flags
+	CursorsTelemetryAppend(TELEMETRY_KIND_REMAP, ((uint32_t)key_in << 24) | ((uint32_t)(message_out & 0xFFFF) << 8) | flags);
+}
+
+
+// Starts a port write if records are waiting and none is in flight, and
+//  queues the counters once a second. Called from GetNextEvent's idle path,
+//  or from our key handler when we joined another INIT's dispatcher and
+//  get no idle calls
+void CursorsTelemetryIdle(void)
+{
+	if (!cursors_telemetry_ready)
+	{
+		return;
+	}
+
+	if (TickCount() >= cursors_telemetry_next_counters)
+	{
+		CursorsTelemetryAppend(TELEMETRY_KIND_KEYS_SEEN, cursors_telemetry_keys_seen);
+		CursorsTelemetryAppend(TELEMETRY_KIND_KEYS_REMAPPED, cursors_telemetry_keys_remapped);
+		CursorsTelemetryAppend(TELEMETRY_KIND_DROPPED, cursors_telemetry_dropped);
+		cursors_telemetry_next_counters = TickCount() + TELEMETRY_COUNTER_TICKS;
+	}
+
+	if (!cursors_telemetry_in_flight)
+	{
+		CursorsTelemetryStartWrite();
+	}
+}
+
+
+// Completion of one async write: frees the slots sent and chains the next
+//  write if more are waiting. Interrupt time. There is only ever one write,
+//  with our own parameter block, so the caller need not pass it
+void CursorsTelemetryWriteDone(void)
+{
+	// even on error, drop what we tried to send rather than retry forever
+	cursors_telemetry_tail = (cursors_telemetry_tail + cursors_telemetry_sending) & TELEMETRY_RING_MASK;
+
+	CursorsTelemetryStartWrite();
+}
@@ -0,0 +1,109 @@
+/*
+ * cursors_telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Optional soak-test telemetry: streams remap decisions and counters out the
+ *  modem port, so a long run on real hardware can be logged by another machine.
+ *
+ * Only built when CURSORS_USE_TELEMETRY is 1 (see custom_cursors.c).
+ *
+ * The event path only appends fixed-size records to a ring buffer. Records go
+ *  out the port through asynchronous Serial Driver writes, chained from the
+ *  write's completion routine, so GetNextEvent never waits on the port.
+ *
+ * Wire format: a plain stream of CursorsTelemetryRecords, 8 bytes each, big
+ *  endian, 57600 baud 8N1, no handshaking. Every record starts with the
+ *  TELEMETRY_SYNC byte so a collector that joins mid-stream can find record
+ *  boundaries. Gaps in seq mean records were dropped because the ring was full.
+ *
+ * All functions here expect A4 to already be set up by the caller.
+ */
+
+#ifndef CURSORS_TELEMETRY_H_
+#define CURSORS_TELEMETRY_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdint.h>
+
+// Platform includes
+#include <Files.h>
+#include <Types.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TELEMETRY_SYNC					0xCC
+
+#define TELEMETRY_KIND_REMAP			1	// data: key in, key out, char out, flags
+#define TELEMETRY_KIND_KEYS_SEEN		2	// data: key events seen since boot
+#define TELEMETRY_KIND_KEYS_REMAPPED	3	// data: key events remapped since boot
+#define TELEMETRY_KIND_DROPPED			4	// data: records dropped since boot (ring full)
+
+#define TELEMETRY_FLAG_REMAPPED			0x01	// REMAP record: message was changed
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct CursorsTelemetryRecord
+{
+	uint8_t		sync;		// always TELEMETRY_SYNC
+	uint8_t		kind;		// TELEMETRY_KIND_xxx
+	uint16_t	seq;		// +1 per record appended (including dropped ones)
+	uint32_t	data;		// depends on kind
+} CursorsTelemetryRecord;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// Opens and configures the modem port. Called once, from main()
+// @param	completion_proc: the write completion routine. It must set up A4
+//			and then call CursorsTelemetryWriteDone()
+// @return	Returns noErr or a Device Manager error; telemetry stays off on error
+OSErr CursorsTelemetryInit(ProcPtr completion_proc);
+
+// Records one remap decision and bumps the counters. Event path: only
+//  appends to the ring, never touches the port
+// @param	key_in: key code before remapping
+// @param	message_in: EventRecord.message before remapping
+// @param	message_out: EventRecord.message after remapping
+void CursorsTelemetryRemap(uint8_t key_in, int32_t message_in, int32_t message_out);
+
+// Starts a port write if records are waiting and none is in flight, and
+//  queues the counters once a second. Called from GetNextEvent's idle path,
+//  or from our key handler when we joined another INIT's dispatcher and
+//  get no idle calls
+void CursorsTelemetryIdle(void);
+
+// Completion of one async write: frees the slots sent and chains the next
+//  write if more are waiting. Interrupt time. There is only ever one write,
+//  with our own parameter block, so the caller need not pass it
+void CursorsTelemetryWriteDone(void);
+
+
+#endif /* CURSORS_TELEMETRY_H_ */
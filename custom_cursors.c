@@ -10,8 +10,9 @@
  * INIT for Mac System 6.x through 9.x that adds alternate key layout when 
  *  specified modifer key is engaged.
  *
- * Works by patching the GetNextEvent trap (tail patch) and modifying the
- *  EventRecord if one of the desired keys has been typed with capslock on
+ * Works by patching the GetNextEvent trap (tail patch), or optionally by
+ *  hooking the jGNEFilter chain, and modifying the EventRecord if one of the
+ *  desired keys has been typed with capslock on
  *
  * Primary reference: 
  *  http://preserve.mactech.com/articles/mactech/Vol.05/05.10/INITinC/index.html
@@ -23,6 +24,61 @@
 // Primary difference with this version is that the cursor keys and modifier 
 //  are designed to be modified via ResEdit by the user, so variables are laid
 //  out with that in mind.
+// All INIT variants are built from this one file. Each variant's project
+//  compiles a small wrapper .c that sets the build options below and then
+//  #includes this file (see custom_cursors_no_frills.c). This file on its own
+//  builds the full "Custom Cursors" INIT.
+
+
+/*****************************************************************************/
+/*                              Build Options                                */
+/*****************************************************************************/
+
+// Draw our ICN# along the bottom of the screen at boot (ShowInitIcon)
+#ifndef CURSORS_SHOW_ICON
+	#define CURSORS_SHOW_ICON		1
+#endif
+
+// Shared dispatcher and runtime keymap interface. Both are found through
+//  Gestalt, so they are of no use before System 6.0.4.
+#ifndef CURSORS_USE_GESTALT
+	#define CURSORS_USE_GESTALT		1
+#endif
+
+// Keystroke journal (record/playback). Controlled through Gestalt, so it
+//  follows CURSORS_USE_GESTALT unless set. Needs cursors_journal.c in the project
+#ifndef CURSORS_USE_JOURNAL
+	#define CURSORS_USE_JOURNAL		CURSORS_USE_GESTALT
+#endif
+
+// Stream remap decisions and counters out the modem port, for soak tests on
+//  real hardware. Off unless asked for. Needs cursors_telemetry.c in the project
+#ifndef CURSORS_USE_TELEMETRY
+	#define CURSORS_USE_TELEMETRY	0
+#endif
+
+// On/off hot-key, and the VBL task that watches for it while we are off
+#ifndef CURSORS_USE_HOTKEY
+	#define CURSORS_USE_HOTKEY		1
+#endif
+
+// Let the ResEdit install-mode byte pick the jGNEFilter hook instead of the
+//  trap patch. The 64K ROM has no jGNEFilter, so it only ever gets the patch
+#ifndef CURSORS_USE_GNE_FILTER
+	#define CURSORS_USE_GNE_FILTER	1
+#endif
+
+// At boot, copy the code into a low NewPtrSys block instead of detaching it
+//  wherever the Resource Manager loaded it. Needs room for a second copy.
+//  Off: in tools/heap_sim it makes the worst boot worse
+#ifndef CURSORS_USE_CODE_COPY
+	#define CURSORS_USE_CODE_COPY	0
+#endif
+
+// Prebuilt layouts (the ResEdit layout byte), matched to the keyboard
+#ifndef CURSORS_USE_LAYOUTS
+	#define CURSORS_USE_LAYOUTS		1
+#endif
 
 
 /*****************************************************************************/
@@ -30,13 +86,30 @@
 /*****************************************************************************/
 
 // project includes
-#include "cursors_show_icon.h"
+#include "cursors_dispatch.h"
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+#if CURSORS_USE_JOURNAL
+	#include "cursors_journal.h"
+#endif
+#if CURSORS_USE_TELEMETRY
+	#include "cursors_telemetry.h"
+#endif
+#if CURSORS_SHOW_ICON
+	#include "cursors_show_icon.h"
+#endif
 
 // C includes
 #include <stdbool.h>
 #include <stdint.h>
 
 // Platform includes
+#if CURSORS_USE_GESTALT
+	#include <GestaltEqu.h>
+#endif
+#if CURSORS_USE_HOTKEY
+	#include <Retrace.h>
+#endif
 #include <SetUpA4.h>
 #include <Traps.h>
 
@@ -46,18 +119,58 @@
 /*****************************************************************************/
 
 #define GetNextEventTrap 			0xA970	// trap address in Mac 128/512/Plus
+#define UnimplementedTrap			0xA89F	// what unimplemented traps point to
+#if CURSORS_USE_CODE_COPY
+	#define HWPrivTrap				0xA198	// OS trap, cache control on 68020 and up
+#endif
+#if CURSORS_USE_GESTALT
+	#define GestaltTrap				0xA1AD	// OS trap, System 6.0.4 and later
+#endif
+#if CURSORS_USE_HOTKEY
+	#define OSDispatchTrap			0xA88F	// only implemented while MultiFinder runs (always in System 7)
+#endif
 
-#define OPT_KEY_MASK				0x0800	// 0b01010000 00000000 = bits for both right option 0x4000 and general options 0x0800
-#define ICON_ID						-16455	// the ID of the ICN# in rsrc file we want to show at startup
+#if CURSORS_SHOW_ICON
+	#define ICON_ID					-16455	// the ID of the ICN# in rsrc file we want to show at startup
+#endif
 
 #define MAP_IDX_UP					0	// pos within cursors_remap_key
 #define MAP_IDX_LEFT				0	// pos within cursors_remap_key
 #define MAP_IDX_DOWN				0	// pos within cursors_remap_key
 #define MAP_IDX_RIGHT				0	// pos within cursors_remap_key
 
-#define MODIFIER_OPT_KEY			0	// Option key
-#define MODIFIER_CAPSLOCK_MODE_1	1	// CapsLock, keeping normal Caps behavior
-#define MODIFIER_CAPSLOCK_MODE_2	2	// CapsLock, neutralizing normal Caps behavior
+#if CURSORS_USE_LAYOUTS
+	#define LAYOUT_RAW				0	// use the key codes in cursors_key / cursors_remap as-is
+	#define LAYOUT_EQUALS_BRACKETS	1	// =, [, ], \ (inverted T on the Mac 128K keyboard)
+	#define LAYOUT_WASD				2	// W, A, S, D
+	#define LAYOUT_IJKL				3	// I, J, K, L
+	#define LAYOUT_KEYPAD_8456		4	// keypad 8, 4, 5, 6
+	#define LAYOUT_KEYPAD_5123		5	// keypad 5, 1, 2, 3
+	#define NUM_LAYOUTS				6
+
+	#define KBD_CLASS_CLASSIC		0	// M0110, M0110A, M0120 keypad: cursor keys from the keypad protocol
+	#define KBD_CLASS_ADB			1	// M0116, M0115, IIgs and other ADB keyboards
+	#define NUM_KBD_CLASSES			2
+
+	#define LM_ROM_BASE				0x02AE	// low mem global: address of start of ROM
+	#define ROM_VERSION_OFFSET		8		// ROM version word is at ROMBase + 8
+	#define ROM_VERSION_FIRST_ADB	0x0076	// Mac SE ROM, the first with ADB
+#endif
+
+#if CURSORS_USE_HOTKEY
+	#define TOGGLE_MODIFIER_MASK	(cmdKey | shiftKey | optionKey | controlKey)	// capslock ignored: may be our modifier
+	#define LM_KEY_MAP				0x0174	// low mem global: 16 byte bitmap of keys currently down
+	#define LM_TICKS				0x016A	// low mem global: ticks since startup
+	#define KEY_CODE_FIRST_MODIFIER	0x37	// command; then shift, capslock, option, control
+	#define MODIFIER_BIT_FIRST		8		// cmdKey bit in EventRecord.modifiers; rest follow in the same order
+#endif
+
+#if CURSORS_USE_GNE_FILTER
+	#define INSTALL_MODE_TRAP_PATCH	0	// tail patch on the GetNextEvent trap
+	#define INSTALL_MODE_GNE_FILTER	1	// hook the jGNEFilter chain instead
+	#define LM_JGNE_FILTER			0x029A	// low mem global: GetNextEvent filter proc
+#endif
+#define LM_ROM85					0x028E	// low mem global: high bit set on 64K ROM
 
 
 /*****************************************************************************/
@@ -65,8 +178,58 @@
 /*****************************************************************************/
 
 static int32_t		cursors_origGetNextEventAddr; // address of original GetNextEvent
-static uint8_t		cursors_last_remapped_key = 0;
-static bool			cursors_last_event_was_remap = false;
+#if CURSORS_USE_GNE_FILTER
+static ProcPtr		cursors_origGNEFilter = NULL;	// filter we chain to, in jGNEFilter mode
+static bool			cursors_use_filter = false;		// hooked jGNEFilter rather than the trap
+
+// LOGIC:
+//   EventAvail runs jGNEFilter too, on an event that stays in the queue, and
+//   GetNextEvent / WaitNextEvent run it again on the same event when the app
+//   takes it. the handlers keep state (the hot-key, repeat tracking, the
+//   journal, telemetry), so they must see each key event only once. the last
+//   key event the filter passed to them is kept as it came in and as they
+//   left it, so a second look at it gets the same answer without them.
+//   the trap patch never sees EventAvail, so only the filter needs this.
+static EventRecord	cursors_filter_raw;				// last key event dispatched, as it came in
+static EventRecord	cursors_filter_out;				// and as the handlers left it
+static Boolean		cursors_filter_result;
+#endif
+static CursorsDispatcher	cursors_dispatcher;	// only used if we are the INIT that patches the trap
+
+// LOGIC:
+//   the event path never reads the ResEdit bytes below directly. main() copies
+//   them into the first of two tables, and a companion app can later push a
+//   new mapping into whichever table is not active, then flip the active
+//   pointer. a 4-byte pointer store is a single move.l, so it can't be seen
+//   half-done. see cursors_keymap.c for how the event path and overlapping
+//   updates keep off each other's table.
+static CursorsKeymapTables		cursors_keymap_tables;
+#if CURSORS_USE_GESTALT
+static CursorsKeymapInterface	cursors_keymap_interface;
+#endif
+#if CURSORS_USE_JOURNAL
+static CursorsJournalInterface	cursors_journal_interface;
+#endif
+static CursorsRemapState	cursors_remap_state = {0, false};
+static bool				cursors_owns_trap = false;	// we hooked GetNextEvent (vs. joined another dispatcher)
+
+#if CURSORS_USE_HOTKEY
+// LOGIC:
+//   the hot-key turns remapping off and on without a reboot. when turning off,
+//   if nobody patched GetNextEvent after us, no other INIT shares our
+//   dispatcher, and MultiFinder is not running, the trap (or jGNEFilter) goes
+//   back to what it was and we cost nothing at all. otherwise our handler
+//   still sees every key event, and returns after the hot-key test.
+//   unhooked, we no longer see key events, so a VBL task watches KeyMap for
+//   the hot-key and turns us back on. it only runs while we are unhooked.
+static volatile bool	cursors_enabled = true;
+static volatile bool	cursors_unhooked = false;	// trap or filter currently restored to original
+static volatile bool	cursors_swallow_toggle = false;	// VBL re-enabled us; eat the hot-key's own keyDown
+static volatile int32_t	cursors_toggle_seen_tick;	// tick the VBL saw that hot-key go down
+static bool				cursors_toggle_armed;		// VBL saw hot-key released since we turned off
+static bool				cursors_vbl_installed = false;
+static VBLTask			cursors_toggle_vbl;
+#endif
 
 // ResEdit modification fun:
 //  the four bytes after "KEYMAP>>" in ResEdit can be changed to whatever key you want
@@ -79,6 +242,11 @@ static bool			cursors_last_event_was_remap = false;
 //  The 5th byte can be 0 (option key), 1 (capslock), or 2 (capslock, with all 
 //    normal capslock behavior removed: most useful if you pick cursor keys that
 //    are not normally used in typing, such as numpad 8456 so you can just leave it on
+//  The 6th byte picks a prebuilt layout (LAYOUT_xxx above). 0 means use the
+//    4 key bytes and the replacement codes exactly as typed in. Anything else
+//    ignores both and uses the layout, with the right cursor key codes for
+//    whichever keyboard is attached, so one config works on every Mac.
+//    Variants built without CURSORS_USE_LAYOUTS don't have this byte
 //  The 8 bytes after the end padding are TWO-byte replacement codes
 //    As set, they work for cursor keys, and most people will never modify them
 //    but you *could* change them to other keys if that's helpful for some reason. 
@@ -87,6 +255,9 @@ static bool			cursors_last_event_was_remap = false;
 static uint8_t		cursors_start_pad[] = "KEYMAP>>";	// ResEdit marker
 static uint8_t		cursors_key[4] = {0x18, 0x21, 0x1E, 0x2A};
 static uint8_t		cursors_modifier_choice = MODIFIER_CAPSLOCK_MODE_2;
+#if CURSORS_USE_LAYOUTS
+static uint8_t		cursors_layout_choice = LAYOUT_RAW;
+#endif
 static uint8_t		cursors_end_pad[] = "<<KEYMAP";	// ResEdit marker
 static uint16_t		cursors_remap[4] = {0x4D1E, 0x461C, 0x481F, 0x421D};
 					// byte 0: // Mac 128K keyboard key from IM I-251
@@ -95,6 +266,47 @@ static uint16_t		cursors_remap[4] = {0x4D1E, 0x461C, 0x481F, 0x421D};
 					// 0x461C; // Left cursor + "FS"
 					// 0x481F; // Down cursor + "US"
 					// 0x421D; // Right cursor + "GS"
+//  The 3 bytes after the replacement codes are the on/off hot-key:
+//    2 bytes of EventRecord modifier bits (0100 = command, 0200 = shift,
+//    0800 = option, 1000 = control, add together), then 1 key code byte.
+//    Key code FF (no such key) means no hot-key. Default is command-option-C.
+//    Only in variants built with CURSORS_USE_HOTKEY
+//  The byte after the hot-key (CURSORS_USE_GNE_FILTER variants only) picks
+//    how we hook into GetNextEvent:
+//    0 patches the trap. 1 hooks the jGNEFilter chain instead, which also
+//    sees events taken with WaitNextEvent and EventAvail. It is
+//    ignored (trap patch used) on the 64K ROM, and if another INIT already
+//    runs the shared dispatcher, since then we don't hook anything ourselves
+#if CURSORS_USE_HOTKEY
+static uint16_t		cursors_toggle_modifiers = cmdKey | optionKey;
+static uint8_t		cursors_toggle_key = 0x08;
+#endif
+#if CURSORS_USE_GNE_FILTER
+static uint8_t		cursors_install_mode = INSTALL_MODE_TRAP_PATCH;
+#endif
+
+#if CURSORS_USE_LAYOUTS
+// LOGIC:
+//   the ROM turns raw keyboard scan codes into the same key codes on every Mac
+//   keyboard, so a logical layout is just one row of key codes. What does
+//   differ by keyboard is the code of the real cursor keys: the keypad-protocol
+//   arrows of the M0110A/M0120 vs the ADB arrows. main() checks the keyboard
+//   once and copies the matching rows into the keymap, so the per-event path
+//   is still one table lookup.
+static const uint8_t	cursors_layout_key[NUM_LAYOUTS - 1][CURSORS_NUM_KEYS] = 
+{
+	{0x18, 0x21, 0x1E, 0x2A},	// LAYOUT_EQUALS_BRACKETS
+	{0x0D, 0x00, 0x01, 0x02},	// LAYOUT_WASD
+	{0x22, 0x26, 0x28, 0x25},	// LAYOUT_IJKL
+	{0x5B, 0x56, 0x57, 0x58},	// LAYOUT_KEYPAD_8456
+	{0x57, 0x53, 0x54, 0x55},	// LAYOUT_KEYPAD_5123
+};
+static const uint16_t	cursors_kbd_remap[NUM_KBD_CLASSES][CURSORS_NUM_KEYS] = 
+{
+	{0x4D1E, 0x461C, 0x481F, 0x421D},	// KBD_CLASS_CLASSIC
+	{0x7E1E, 0x7B1C, 0x7D1F, 0x7C1D},	// KBD_CLASS_ADB
+};
+#endif
 
 /*****************************************************************************/
 /*                             Global Variables                              */
@@ -107,168 +319,798 @@ static uint16_t		cursors_remap[4] = {0x4D1E, 0x461C, 0x481F, 0x421D};
 
 void main(void);
 
-// Intercept key events for our specified key combinations and modify them to
-// be cursor keys instead. For any other combo, pass thru keys without mod.
-//   Calls ToolBox GetNextEvent, modifies EventRecord.message if appropriate
+// Sets up the keymap and installs the patch or filter (or joins another dispatcher).
+//   Runs in the resident copy of the code: called with A0 = start of it
+void CursorsInstall(void);
+
+#if CURSORS_USE_CODE_COPY
+// HWPriv selector 1: FlushInstructionCache. Only call if _HWPriv exists
+pascal void CursorsFlushCodeCache(void) = {0x7001, 0xA198};
+#endif
+
+// Shared dispatcher patch for GetNextEvent.
+//   Calls ToolBox GetNextEvent once, then runs every registered key handler
+//   over the event in a single pass
 // @return	Returns true if toolbox GetNextEvent returned true (an event needs processing)
 pascal Boolean NewGetNextEvent(short eventMask, EventRecord *theEvent);
 
+#if CURSORS_USE_GNE_FILTER
+// Shared dispatcher hooked into the jGNEFilter chain instead of the trap.
+//   Called by GetNextEvent and WaitNextEvent with A1 pointing at the event;
+//   gne_result is the Boolean result word the caller left on the stack
+void CursorsGNEFilter(int16_t gne_result);
+
+// C side of the jGNEFilter hook: runs the dispatcher core over the event,
+//   only once per event even if the app peeked at it with EventAvail first
+// @return	Returns event_needs_action, or false if a handler swallowed the event
+static Boolean CursorsFilterEvent(Boolean event_needs_action, EventRecord *theEvent);
+#endif
+
+// Dispatcher core shared by both install modes: runs every registered key
+//   handler over a key event, or does deferred work if there is no event
+// @return	Returns event_needs_action, or false if a handler swallowed the event
+static Boolean CursorsDispatchEvent(Boolean event_needs_action, EventRecord *theEvent);
+
+// Hooks GetNextEvent in whichever mode we installed in: trap or filter.
+//   Picks up the current trap address / filter, so it is also used to rehook
+static void CursorsHook(void);
+
+#if CURSORS_USE_HOTKEY
+// Puts GetNextEvent (or jGNEFilter) back the way it was before CursorsHook(),
+//   but only if it still points at us: nobody hooked in on top since
+// @return	Returns true if unhooked
+static bool CursorsUnhook(void);
+#endif
+
+// Key handler registered with the dispatcher (ours or another INIT's).
+// Intercept key events for our specified key combinations and modify them to
+// be cursor keys instead. For any other combo, pass thru keys without mod.
+//   Modifies EventRecord.message if appropriate
+pascal void CursorsRemapKey(EventRecord *theEvent);
+
+#if CURSORS_USE_LAYOUTS
+// Works out which family of keyboard is attached, once, at install time
+// @return	Returns KBD_CLASS_CLASSIC or KBD_CLASS_ADB
+static uint8_t CursorsKeyboardClass(void);
+#endif
+
+#if CURSORS_USE_HOTKEY
+// @return	Returns true if the event is the hot-key, with its exact modifiers
+static bool CursorsIsToggleKey(const EventRecord *theEvent);
+
+// Turns remapping off. Called from our key handler when the hot-key is typed.
+//   Unhooks GetNextEvent entirely if that is safe, and then starts the VBL
+//   watcher
+static void CursorsDisable(void);
+
+// VBL task, only active while we are unhooked. Watches KeyMap for the
+//   hot-key, then rehooks GetNextEvent and turns remapping back on
+void CursorsToggleVBL(void);
+
+// Checks KeyMap for the hot-key and its exact modifiers
+// @return	Returns true if the hot-key combination is down right now
+static bool CursorsToggleKeyDown(void);
+
+// Checks if MultiFinder is running (System 7 always counts)
+// @return	Returns true if trap patches made now would only apply to the current app
+static bool CursorsMultiFinderRunning(void);
+#endif
+
+#if CURSORS_USE_TELEMETRY
+// Serial write completion routine: sets up A4, then lets cursors_telemetry.c
+//   chain the next write. Interrupt time
+void CursorsTelemetryCompletion(void);
+#endif
+
+#if CURSORS_USE_JOURNAL
+// Journal file write completion routine: sets up A4, then lets
+//   cursors_journal.c free the slots written. Interrupt time
+void CursorsJournalCompletion(void);
+#endif
+
+#if CURSORS_USE_GESTALT
+// Gestalt function publishing our dispatcher to INITs that load after us,
+//  and the runtime keymap interface to companion apps
+pascal OSErr CursorsGestalt(OSType selector, long *response);
+
+// Builds a new mapping into the inactive table and publishes it.
+//   Safe at application time and at interrupt time (no Memory Manager calls)
+// @return	Returns noErr, paramErr if the mapping is invalid, or CURSORS_KEYMAP_ERR_BUSY
+pascal OSErr CursorsSetKeymap(const CursorsKeymap *new_map);
+
+// Copies the currently active mapping into current_map
+// @return	Returns noErr, or CURSORS_KEYMAP_ERR_BUSY if it interrupted a set or get
+pascal OSErr CursorsGetKeymap(CursorsKeymap *current_map);
+
+#if CURSORS_USE_JOURNAL
+// Journal interface entry points: set up A4, then call into cursors_journal.c
+pascal OSErr CursorsStartRecording(void);
+pascal OSErr CursorsStopRecording(void);
+pascal OSErr CursorsStartPlayback(void);
+#endif
+
+// Checks if the Gestalt trap is implemented (System 6.0.4 and later)
+static bool CursorsGestaltAvailable(void);
+
+// Looks for a dispatcher already installed by a cooperating INIT.
+//   Any version: CursorsDispatchRegister() decides if we can join it
+// @return	Returns pointer to the dispatcher, or NULL if none (or Gestalt not available)
+static CursorsDispatcher* CursorsFindDispatcher(void);
+#endif
+
 
 /*****************************************************************************/
 /*                       Private Function Definitions                        */
 /*****************************************************************************/
 
 
-// Intercept key events for our specified key combinations and modify them to
-// be cursor keys instead. For any other combo, pass thru keys without mod.
-//   Calls ToolBox GetNextEvent, modifies EventRecord.message if appropriate
+// Shared dispatcher patch for GetNextEvent.
+//   Calls ToolBox GetNextEvent once, then runs every registered key handler
+//   over the event in a single pass
 // @return	Returns true if toolbox GetNextEvent returned true (an event needs processing)
 pascal Boolean NewGetNextEvent(short eventMask, EventRecord *theEvent)
 {
-	uint8_t		the_key;
-	uint8_t		the_char;	// needed for unshifting in capslock modes
-	int16_t		i;
-	uint32_t	modified_code_and_char = 0;
 	bool		event_needs_action;
-	bool		is_repeat_of_last;
-	bool		do_remap;
-	bool		modifier_down;
 
 	// LOGIC:
 	//   call original GetNextEvent()
-	//   if the event is a keydown event, inspect modifier. if not Option key, return
-	//   inspect the key. If [, ], \, or =, translate to a cursor key
-	//   before returning, remove option key from the modifiers, but do not clear them. 
-	//     this allows SHIFT-cursor-right etc.
+	//   then hand the event to the dispatcher core, same as the filter does
+	//   non-key events cost exactly one trap hop, however many INITs registered
 	
 	SetUpA4();
 
 	// call original GetNextEvent
 	event_needs_action = CallPascalB(eventMask, theEvent, cursors_origGetNextEventAddr);
 
+	event_needs_action = CursorsDispatchEvent(event_needs_action, theEvent);
+	
+	RestoreA4();
+	
+	return event_needs_action;
+}
+
+
+#if CURSORS_USE_GNE_FILTER
+// Shared dispatcher hooked into the jGNEFilter chain instead of the trap.
+//   Called by GetNextEvent and WaitNextEvent with A1 pointing at the event;
+//   gne_result is the Boolean result word the caller left on the stack
+void CursorsGNEFilter(int16_t gne_result)
+{
+	EventRecord*	the_event;
+	ProcPtr			next_filter;
+
+	// LOGIC:
+	//   the Event Manager JSRs here after it has the event, with A1 pointing at
+	//   the EventRecord and the function result as a word at 4(SP). That word is
+	//   where a C function (2-byte int) finds its first parameter, so writing
+	//   gne_result changes what GetNextEvent / WaitNextEvent return. It is a
+	//   Pascal Boolean, so the value is in its high byte.
+	//   A1 has to be grabbed first: SetUpA4 uses it.
+	//   the filter that was installed before us runs first, the same order the
+	//   trap patch gets by calling the original trap first. it is called the
+	//   way the Event Manager calls us, with its own copy of the result word.
+	//   this is only the register glue: CursorsFilterEvent() does the rest.
+
+	asm
+	{
+		move.l	A1, the_event
+	}
+	
+	SetUpA4();
+	
+	next_filter = cursors_origGNEFilter;
+	
+	if (next_filter != NULL)
+	{
+		asm
+		{
+			movem.l	D3-D7/A2-A4, -(SP)
+			move.w	gne_result, -(SP)
+			movea.l	the_event, A1
+			move.w	gne_result, D0
+			movea.l	next_filter, A0
+			jsr		(A0)
+			move.w	(SP)+, gne_result
+			movem.l	(SP)+, D3-D7/A2-A4
+		}
+	}
+	
+	gne_result = CursorsFilterEvent((gne_result >> 8) != 0, the_event) << 8;
+	
+	RestoreA4();
+	
+	// leave things as we found them for the Event Manager
+	asm
+	{
+		movea.l	the_event, A1
+		move.w	gne_result, D0
+	}
+}
+
+
+// C side of the jGNEFilter hook: runs the dispatcher core over the event,
+//   only once per event even if the app peeked at it with EventAvail first
+// @return	Returns event_needs_action, or false if a handler swallowed the event
+static Boolean CursorsFilterEvent(Boolean event_needs_action, EventRecord *theEvent)
+{
+	// LOGIC:
+	//   a key event the same as the last one dispatched, down to its tick
+	//   count, is the same event seen again: EventAvail first, then the call
+	//   that takes it. two real key events don't share a tick and a message.
+	//   it gets what the handlers made of it the first time. null events
+	//   aren't kept: running the idle work twice does no harm.
+	
+	if (!event_needs_action || (theEvent->what != keyDown && theEvent->what != autoKey))
+	{
+		return CursorsDispatchEvent(event_needs_action, theEvent);
+	}
+	
+	if (theEvent->what == cursors_filter_raw.what && theEvent->message == cursors_filter_raw.message
+		&& theEvent->when == cursors_filter_raw.when && theEvent->modifiers == cursors_filter_raw.modifiers)
+	{
+		*theEvent = cursors_filter_out;
+		return cursors_filter_result;
+	}
+	
+	cursors_filter_raw = *theEvent;
+	cursors_filter_result = CursorsDispatchEvent(event_needs_action, theEvent);
+	cursors_filter_out = *theEvent;
+	
+	return cursors_filter_result;
+}
+#endif
+
+
+// Dispatcher core shared by both install modes: runs every registered key
+//   handler over a key event, or does deferred work if there is no event
+// @return	Returns event_needs_action, or false if a handler swallowed the event
+static Boolean CursorsDispatchEvent(Boolean event_needs_action, EventRecord *theEvent)
+{
+	// LOGIC:
+	//   if the event is a keydown event, hand it to each registered handler in turn
+	//   a handler can swallow the event by turning it into a null event
+	//   the journal records the event only once every handler has had it, so
+	//   it holds what the app gets, including what INITs that joined after us
+	//   did to it. swallowed events never reach the app, so are not recorded
+	//   called with A4 already set up
+	
 	if (event_needs_action)
 	{
 		if (theEvent->what == keyDown || theEvent->what == autoKey)
 		{
-			// determine if selected modifier is down, then do universal check for the key
-			// can't return even if modifier not down until we check for key repeat
-			// key repeat events do not include the modifier key info!
-			
-			switch(cursors_modifier_choice)
+			if (CursorsDispatchKey(&cursors_dispatcher, theEvent))
 			{
-				case MODIFIER_CAPSLOCK_MODE_1:
-				case MODIFIER_CAPSLOCK_MODE_2:
-					modifier_down = ((theEvent->modifiers & alphaLock) > 0);
-					break;
-				
-				case MODIFIER_OPT_KEY:
-					modifier_down = ((theEvent->modifiers & optionKey) > 0);
-					break;
-				
-				default:
-					// modifier not down, but need to check if this is a repeat event before giving up
-					break;
+				event_needs_action = false;
 			}
-			
-			// LOGIC:
-			//   do remapping if:
-			//     (the modifier is down AND a specified key is down) OR
-			//     (it is a key repeat event AND the repeat key matches one 
-			//         of our keys AND we previously set flag that we are 
-			//         remapping)
-			
-		    the_key = (theEvent->message & keyCodeMask) >> 8;
-		    the_char = theEvent->message & charCodeMask;
-			is_repeat_of_last = (the_key == cursors_last_remapped_key && cursors_last_event_was_remap);
-			do_remap = ((modifier_down || is_repeat_of_last) > 0);
-			
-			if (do_remap == true)
-		    {
-				// LOGIC:
-				//   we have array for key to map (1 byte)
-				//   and array for key to map to (2 bytes)
-				//   same offsets used for both, so no need to different 
-				//   code per key (all are co-equal and get same simple swap)
-				
-				for (i = 0; i < 4; i++)
-				{
-					if (the_key == cursors_key[i])
-					{
-						modified_code_and_char = cursors_remap[i];
-					}
-				}
-			
-				if (modified_code_and_char)
-				{
-					// re-mask by blanking out lower 2 bytes, preserving 3rd/4th byte
-					theEvent->message = (theEvent->message & 0xFFFF0000) | modified_code_and_char;
-
-					// different behavior depending on modifier choice
-					// note that MODIFIER_CAPSLOCK_MODE_2 is handled further down
-					//  because it applies even if not working with a remap key
-					
-					if (cursors_modifier_choice == MODIFIER_OPT_KEY)
-					{
-						// clear the option modifier only, leaving any shift, control, etc.
-						// this means that essentially, you can't do option [, ], = or \. boohoo.					
-						theEvent->modifiers &= ~(OPT_KEY_MASK);
-					}
-					else if (cursors_modifier_choice == MODIFIER_CAPSLOCK_MODE_1)
-					{
-						// clear the capslock modifier only, leaving any shift, control, option, etc.
-						theEvent->modifiers &= ~(alphaLock);
-						
-						// LOGIC:
-						//   it is not necessary for us to remap upper to lower
-						//   for capslock mode 1 because wee already remapped THIS key
-						//   to a cursor key. Capsmode 2 below will remap chars to lower if necessar.
-					}					
+#if CURSORS_USE_JOURNAL
+			else if (cursors_journal_state == JOURNAL_RECORDING)
+			{
+				CursorsJournalAppend(theEvent);
+			}
+#endif
+		}
+	}
+#if CURSORS_USE_JOURNAL || CURSORS_USE_TELEMETRY
+	else
+	{
+		// nothing for the app to do, so now is when deferred work can run
+#if CURSORS_USE_JOURNAL
+		if (cursors_journal_state != JOURNAL_OFF)
+		{
+			CursorsJournalIdle();
+		}
+#endif
+#if CURSORS_USE_TELEMETRY
+		CursorsTelemetryIdle();
+#endif
+	}
+#endif
+	
+	return event_needs_action;
+}
+
+
+// Hooks GetNextEvent in whichever mode we installed in: trap or filter.
+//   Picks up the current trap address / filter, so it is also used to rehook
+static void CursorsHook(void)
+{
+#if CURSORS_USE_GNE_FILTER
+	if (cursors_use_filter)
+	{
+		cursors_origGNEFilter = *(ProcPtr*)LM_JGNE_FILTER;
+		*(ProcPtr*)LM_JGNE_FILTER = (ProcPtr)CursorsGNEFilter;
+		return;
+	}
+#endif
+	
+	cursors_origGetNextEventAddr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)NewGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+}
+
+
+#if CURSORS_USE_HOTKEY
+// Puts GetNextEvent (or jGNEFilter) back the way it was before CursorsHook(),
+//   but only if it still points at us: nobody hooked in on top since
+// @return	Returns true if unhooked
+static bool CursorsUnhook(void)
+{
+#if CURSORS_USE_GNE_FILTER
+	if (cursors_use_filter)
+	{
+		if (*(ProcPtr*)LM_JGNE_FILTER != (ProcPtr)CursorsGNEFilter)
+		{
+			return false;
+		}
+		
+		*(ProcPtr*)LM_JGNE_FILTER = cursors_origGNEFilter;
+		return true;
+	}
+#endif
+	
+	if (NGetTrapAddress((int)GetNextEventTrap, ToolTrap) != (long)NewGetNextEvent)
+	{
+		return false;
+	}
+	
+	NSetTrapAddress(cursors_origGetNextEventAddr, (int)GetNextEventTrap, ToolTrap);
+	return true;
+}
+#endif
+
+
+// Key handler registered with the dispatcher (ours or another INIT's).
+// Intercept key events for our specified key combinations and modify them to
+// be cursor keys instead. For any other combo, pass thru keys without mod.
+//   Modifies EventRecord.message if appropriate
+pascal void CursorsRemapKey(EventRecord *theEvent)
+{
+	const CursorsKeymap*	map;
+#if CURSORS_USE_TELEMETRY
+	int32_t		message_in;
+#endif
+
+	// LOGIC:
+	//   dispatcher only calls us for keydown and autokey events
+	//   deal with the on/off hot-key, then pin down which keymap table to use,
+	//   and hand the event to the remap core (cursors_remap.c)
+	//   we may be called from another INIT's dispatcher, so set up our own A4
+	
+	SetUpA4();
+
+#if CURSORS_USE_HOTKEY
+	if (CursorsIsToggleKey(theEvent))
+	{
+		// LOGIC:
+		//   the hot-key itself is never passed on to the app. its keyDown turns
+		//   us off, or back on if we were only bypassing.
+		//   when the VBL turned us back on, the keyDown of that same press may
+		//   still be on its way to us. it was posted no later than the tick the
+		//   VBL saw the key go down, so a keyDown from after that is a new
+		//   press. if the app already got the first one (it was taken before
+		//   the VBL rehooked us), the flag left behind can't eat the next press
 		
-					cursors_last_remapped_key = the_key;
-					cursors_last_event_was_remap = true;
-				}
+		if (theEvent->what == keyDown)
+		{
+			if (!cursors_enabled)
+			{
+				cursors_enabled = true;
 			}
-			else
+			else if (!cursors_swallow_toggle || theEvent->when > cursors_toggle_seen_tick)
 			{
-				cursors_last_event_was_remap = false;
+				CursorsDisable();
 			}
+		}
+		
+		cursors_swallow_toggle = false;
+		theEvent->what = nullEvent;
+		RestoreA4();
+		return;
+	}
+	
+	if (!cursors_enabled)
+	{
+		// still chained (shared dispatcher, MultiFinder, or someone patched on
+		//  top of us) so this is our bypass: out after the hot-key test
+		RestoreA4();
+		return;
+	}
+	
+	cursors_swallow_toggle = false;
+#endif
+	
+	// everything below reads only through 'map'
+	map = CursorsKeymapPin(&cursors_keymap_tables);
+	
+#if CURSORS_USE_TELEMETRY
+	message_in = theEvent->message;
+#endif
+
+	CursorsRemapEvent(theEvent, map, &cursors_remap_state);
+	
+#if CURSORS_USE_TELEMETRY
+	CursorsTelemetryRemap((message_in & keyCodeMask) >> 8, message_in, theEvent->message);
+#endif
+	
+	CursorsKeymapUnpin(&cursors_keymap_tables);
+	
+#if CURSORS_USE_JOURNAL
+	// when we joined another INIT's dispatcher, this is as late as we get to
+	//  see the event: handlers registered after ours may still change it.
+	//  with our own dispatcher, CursorsDispatchEvent() records it instead.
+	//  there is no idle time to write the ring out then, so it starts here
+	if (!cursors_owns_trap && cursors_journal_state == JOURNAL_RECORDING)
+	{
+		CursorsJournalAppend(theEvent);
+		CursorsJournalDrain();
+	}
+#endif
+	
+#if CURSORS_USE_TELEMETRY
+	// the same goes for the telemetry: without idle calls, the key path
+	//  sends the ring and the counters
+	if (!cursors_owns_trap)
+	{
+		CursorsTelemetryIdle();
+	}
+#endif
+	
+	RestoreA4();
+}
+
+
+#if CURSORS_USE_HOTKEY
+// @return	Returns true if the event is the hot-key, with its exact modifiers
+static bool CursorsIsToggleKey(const EventRecord *theEvent)
+{
+	return (((theEvent->message & keyCodeMask) >> 8) == cursors_toggle_key
+		&& (theEvent->modifiers & TOGGLE_MODIFIER_MASK) == cursors_toggle_modifiers);
+}
+
+
+// Turns remapping off. Called from our key handler when the hot-key is typed.
+//   Unhooks GetNextEvent entirely if that is safe, and then starts the VBL
+//   watcher
+static void CursorsDisable(void)
+{
+	// LOGIC:
+	//   safe to unhook only if:
+	//     we installed the patch, and nobody else uses our dispatcher, and
+	//     the trap (or jGNEFilter) still points at us (nobody hooked on top
+	//     since boot), and
+	//     MultiFinder is not running. under MultiFinder a trap set while an
+	//     app runs is that app's alone: unhooking would only take us out of
+	//     the app in front, and the VBL would later rehook in whichever app
+	//     is in front then, on top of the patch that app still has from boot.
+	//     so there, like when someone else shares the hook, we only bypass
+	//   we are called from inside NewGetNextEvent (or the filter), but
+	//   restoring the hook only affects the next call, so this event
+	//   finishes normally.
+	//   when we only bypass, the handler sees the hot-key itself: no VBL
+	
+	cursors_enabled = false;
+	cursors_remap_state.last_event_was_remap = false;
+	cursors_toggle_armed = false;
+	
+	if (cursors_owns_trap && cursors_dispatcher.handler_count == 1 && !CursorsMultiFinderRunning())
+	{
+		cursors_unhooked = CursorsUnhook();
+	}
+	
+	if (!cursors_unhooked)
+	{
+		return;
+	}
+	
+	cursors_toggle_vbl.vblCount = 1;
+	
+	if (!cursors_vbl_installed)
+	{
+		cursors_toggle_vbl.qType = vType;
+		cursors_toggle_vbl.vblAddr = (ProcPtr)CursorsToggleVBL;
+		cursors_toggle_vbl.vblPhase = 0;
+		cursors_vbl_installed = (VInstall((QElemPtr)&cursors_toggle_vbl) == noErr);
+	}
+}
+
+
+// VBL task, only active while we are unhooked. Watches KeyMap for the
+//   hot-key, then rehooks GetNextEvent and turns remapping back on
+void CursorsToggleVBL(void)
+{
+	// LOGIC:
+	//   the hot-key is probably still down from turning us off, so it has to be
+	//   seen released once (armed) before a press counts.
+	//   rehooking here, at interrupt time, is just one store into the trap
+	//   table (or jGNEFilter). the app is either not inside GetNextEvent, or
+	//   inside the original one, which doesn't care. next call comes through
+	//   us. picking up the current address (not the one from boot) keeps
+	//   anyone who hooked in while we were unhooked in the chain.
+	//   an app that called GetNextEvent since the key went down has already
+	//   got its keyDown; we could not see it. otherwise our handler eats it:
+	//   it knows it by its tick, see CursorsRemapKey().
+	//   vblCount left at 0 makes the task dormant until the next disable.
+	
+	SetUpA4();
+	
+	if (!CursorsToggleKeyDown())
+	{
+		cursors_toggle_armed = true;
+		cursors_toggle_vbl.vblCount = 1;
+	}
+	else if (!cursors_toggle_armed)
+	{
+		cursors_toggle_vbl.vblCount = 1;
+	}
+	else
+	{
+		if (cursors_unhooked)
+		{
+			CursorsHook();
+			cursors_unhooked = false;
+		}
+		
+		cursors_toggle_seen_tick = *(int32_t*)LM_TICKS;
+		cursors_swallow_toggle = true;
+		cursors_enabled = true;
+		cursors_toggle_vbl.vblCount = 0;
+	}
+	
+	RestoreA4();
+}
+
+
+// Checks KeyMap for the hot-key and its exact modifiers
+// @return	Returns true if the hot-key combination is down right now
+static bool CursorsToggleKeyDown(void)
+{
+	uint8_t*	key_map;
+	int16_t		i;
+	uint16_t	the_bit;
+	bool		is_down;
+	
+	key_map = (uint8_t*)LM_KEY_MAP;
+	
+	if (!((key_map[cursors_toggle_key >> 3] >> (cursors_toggle_key & 7)) & 1))
+	{
+		return false;
+	}
+	
+	// modifier key codes run command, shift, capslock, option, control
+	//  in the same order as their bits in EventRecord.modifiers
+	for (i = 0; i < 5; i++)
+	{
+		the_bit = 1 << (MODIFIER_BIT_FIRST + i);
+		
+		if (the_bit & TOGGLE_MODIFIER_MASK)
+		{
+			is_down = ((key_map[(KEY_CODE_FIRST_MODIFIER + i) >> 3] >> ((KEY_CODE_FIRST_MODIFIER + i) & 7)) & 1);
 			
-			// for capslock mode 2 only: ALWAYS neutralize capslock on key down
-			// even if for keys we aren't mapping. The goal is to let the user
-			// just leave the capslock on permanently, and have cursors, but other-
-			// wise totally normal key behavior. Obviously, not good for IJKL, but
-			// good if you have a numpad and map to 8456 or 5123 etc.
-			if (cursors_modifier_choice == MODIFIER_CAPSLOCK_MODE_2)
+			if (is_down != ((cursors_toggle_modifiers & the_bit) != 0))
 			{
-				// clear the capslock modifier only, leaving any shift, control, option, etc.
-				// this means there is no capslock-like behavior				
-				theEvent->modifiers &= ~(alphaLock);
-
-				// LOGIC: 
-				//   The above will not actually accomplish much, other than
-				//   letting any program testing for CapsLock know it isn't
-				//   supposed to be on. The reason is that the keys have already been
-				//   shifted by this point. Next thing we do is unshift alpha keys.
-				//   note that we don't want to prevent caps if shift down
-				
-				if (the_char >= 'A' & the_char <= 'Z')
-				{
-					if ((theEvent->modifiers & shiftKey) < 1)
-					{
-						the_char += 32;	// diff between upper and lower in Mac ASCII
-						theEvent->message = (theEvent->message & ~charCodeMask) | the_char;
-					}
-				}
+				return false;
 			}
 		}
 	}
 	
+	return true;
+}
+
+
+// Checks if MultiFinder is running (System 7 always counts)
+// @return	Returns true if trap patches made now would only apply to the current app
+static bool CursorsMultiFinderRunning(void)
+{
+	// LOGIC:
+	//   _OSDispatch is only there while MultiFinder runs, which is the check
+	//   Apple gives. under System 6 that can only be known once the Finder or
+	//   MultiFinder is up, so it is asked when the hot-key is used, not at
+	//   boot. the 64K ROM predates MultiFinder.
+	
+	if (*(int16_t*)LM_ROM85 < 0)
+	{
+		return false;
+	}
+	
+	return (NGetTrapAddress((int)OSDispatchTrap, ToolTrap) != NGetTrapAddress((int)UnimplementedTrap, ToolTrap));
+}
+#endif
+
+
+#if CURSORS_USE_TELEMETRY
+// Serial write completion routine: sets up A4, then lets cursors_telemetry.c
+//   chain the next write. Interrupt time
+void CursorsTelemetryCompletion(void)
+{
+	// the Device Manager passes the parameter block in A0, but there is only
+	//  ever one telemetry write, so cursors_telemetry.c knows which it is
+	SetUpA4();
+	CursorsTelemetryWriteDone();
+	RestoreA4();
+}
+#endif
+
+
+#if CURSORS_USE_JOURNAL
+// Journal file read / write completion routine: sets up A4, then lets
+//   cursors_journal.c take the records read or free the slots written.
+//   Interrupt time
+void CursorsJournalCompletion(void)
+{
+	// the File Manager passes the parameter block in A0, but there is only
+	//  ever one journal read or write, so cursors_journal.c knows which it is
+	SetUpA4();
+	CursorsJournalIODone();
 	RestoreA4();
+}
+#endif
+
+
+#if CURSORS_USE_LAYOUTS
+// Works out which family of keyboard is attached, once, at install time
+// @return	Returns KBD_CLASS_CLASSIC or KBD_CLASS_ADB
+static uint8_t CursorsKeyboardClass(void)
+{
+	Ptr			rom_base;
+	uint16_t	rom_version;
 	
-	return event_needs_action;
+	// LOGIC:
+	//   every ROM from the SE on talks to its keyboard over ADB, and every one
+	//   before it (128K, 512K, 512Ke, Plus) uses the keyboard-cable protocol.
+	//   the ROM version word works from the 64K ROM up, unlike SysEnvirons
+	//   or Gestalt, so it is safe for System 1.x too.
+	
+	rom_base = *(Ptr*)LM_ROM_BASE;
+	rom_version = *(uint16_t*)(rom_base + ROM_VERSION_OFFSET);
+	
+	return (rom_version >= ROM_VERSION_FIRST_ADB) ? KBD_CLASS_ADB : KBD_CLASS_CLASSIC;
+}
+#endif
+
+
+#if CURSORS_USE_GESTALT
+// Gestalt function publishing our dispatcher to INITs that load after us,
+//  and the runtime keymap interface to companion apps
+pascal OSErr CursorsGestalt(OSType selector, long *response)
+{
+	SetUpA4();
+	
+	switch (selector)
+	{
+		case CURSORS_KEYMAP_SELECTOR:
+			*response = (long)&cursors_keymap_interface;
+			break;
+		
+#if CURSORS_USE_JOURNAL
+		case CURSORS_JOURNAL_SELECTOR:
+			*response = (long)&cursors_journal_interface;
+			break;
+#endif
+		
+		default:
+			*response = (long)&cursors_dispatcher;
+			break;
+	}
+	
+	RestoreA4();
+	
+	return noErr;
+}
+
+
+// Builds a new mapping into the inactive table and publishes it.
+//   Safe at application time and at interrupt time (no Memory Manager calls)
+// @return	Returns noErr, paramErr if the mapping is invalid, or CURSORS_KEYMAP_ERR_BUSY
+pascal OSErr CursorsSetKeymap(const CursorsKeymap *new_map)
+{
+	OSErr			the_err;
+	
+	SetUpA4();
+	
+	the_err = CursorsKeymapSet(&cursors_keymap_tables, new_map);
+	
+	if (the_err == noErr)
+	{
+		// a repeat chain started under the old mapping should not carry over
+		cursors_remap_state.last_event_was_remap = false;
+	}
+	
+	RestoreA4();
+	
+	return the_err;
+}
+
+
+// Copies the currently active mapping into current_map
+// @return	Returns noErr, or CURSORS_KEYMAP_ERR_BUSY if it interrupted a set or get
+pascal OSErr CursorsGetKeymap(CursorsKeymap *current_map)
+{
+	OSErr			the_err;
+	
+	SetUpA4();
+	
+	the_err = CursorsKeymapGet(&cursors_keymap_tables, current_map);
+	
+	RestoreA4();
+	
+	return the_err;
 }
 
 
+#if CURSORS_USE_JOURNAL
+// Journal interface entry points: set up A4, then call into cursors_journal.c
+pascal OSErr CursorsStartRecording(void)
+{
+	OSErr	the_err;
+	
+	SetUpA4();
+	the_err = CursorsJournalStartRecording();
+	RestoreA4();
+	
+	return the_err;
+}
+
+
+pascal OSErr CursorsStopRecording(void)
+{
+	OSErr	the_err;
+	
+	SetUpA4();
+	the_err = CursorsJournalStopRecording();
+	RestoreA4();
+	
+	return the_err;
+}
+
+
+pascal OSErr CursorsStartPlayback(void)
+{
+	OSErr	the_err;
+	
+	SetUpA4();
+	the_err = CursorsJournalStartPlayback();
+	RestoreA4();
+	
+	return the_err;
+}
+#endif
+
+
+// Checks if the Gestalt trap is implemented (System 6.0.4 and later)
+static bool CursorsGestaltAvailable(void)
+{
+	return (NGetTrapAddress((int)GestaltTrap, OSTrap) != NGetTrapAddress((int)UnimplementedTrap, ToolTrap));
+}
+
+
+// Looks for a dispatcher already installed by a cooperating INIT.
+//   Any version: CursorsDispatchRegister() decides if we can join it
+// @return	Returns pointer to the dispatcher, or NULL if none (or Gestalt not available)
+static CursorsDispatcher* CursorsFindDispatcher(void)
+{
+	long				response;
+	CursorsDispatcher*	the_dispatcher;
+	
+	// LOGIC:
+	//   Gestalt only exists from System 6.0.4 on. Before that, nobody can
+	//   have published a dispatcher, so we just patch the trap as always.
+	
+	if (!CursorsGestaltAvailable())
+	{
+		return NULL;
+	}
+	
+	if (Gestalt(CURSORS_DISPATCH_SELECTOR, &response) != noErr)
+	{
+		return NULL;
+	}
+	
+	the_dispatcher = (CursorsDispatcher*)response;
+	
+	return the_dispatcher;
+}
+#endif
+
+
 
 
 /*****************************************************************************/
@@ -291,18 +1133,163 @@ pascal Boolean NewGetNextEvent(short eventMask, EventRecord *theEvent)
 
 // **** OTHER FUNCTIONS *****
 
-// Installs a patch to GetNextEvent so that all future calls route
-//  through our private version first
+// Sets up the keymap, then registers our key handler with a cooperating
+//  INIT's GetNextEvent dispatcher if one is already installed. Otherwise
+//  installs a patch to GetNextEvent (or hooks jGNEFilter, if configured)
+//  so that all future calls route through our dispatcher first.
+//   Runs in the resident copy of the code: called with A0 = start of it
+void CursorsInstall(void)
+{
+#if CURSORS_USE_JOURNAL
+	SysEnvRec			world;
+#endif
+	CursorsDispatcher*	the_dispatcher;
+	CursorsKeymap		initial_map;
+	int16_t				i;
+#if CURSORS_USE_LAYOUTS
+	uint8_t				kbd_class;
+#endif
+
+	// LOGIC:
+	//  main() may have just copied us somewhere else, so A4 (the start of the
+	//   code resource, where our globals live) has to be remembered again,
+	//   for this copy. from here on every function address we take is in
+	//   the copy, which is what the patches and tasks must point at.
+	//  If another INIT already owns a compatible dispatcher, we only add our
+	//   handler to it, so the trap chain does not grow by another hop.
+
+ 	RememberA0();
+ 	SetUpA4();
+ 	
+	// starting mapping is whatever the user set up with ResEdit: either
+	//  raw key codes, or a prebuilt layout matched to this keyboard
+	for (i = 0; i < CURSORS_NUM_KEYS; i++)
+	{
+		initial_map.key[i] = cursors_key[i];
+		initial_map.remap[i] = cursors_remap[i];
+	}
+	
+#if CURSORS_USE_LAYOUTS
+	if (cursors_layout_choice != LAYOUT_RAW && cursors_layout_choice < NUM_LAYOUTS)
+	{
+		kbd_class = CursorsKeyboardClass();
+		
+		for (i = 0; i < CURSORS_NUM_KEYS; i++)
+		{
+			initial_map.key[i] = cursors_layout_key[cursors_layout_choice - 1][i];
+			initial_map.remap[i] = cursors_kbd_remap[kbd_class][i];
+		}
+	}
+#endif
+	
+	initial_map.modifier_choice = cursors_modifier_choice;
+	initial_map.reserved = 0;
+	CursorsKeymapInit(&cursors_keymap_tables, &initial_map);
+	
+#if CURSORS_USE_GESTALT
+	the_dispatcher = CursorsFindDispatcher();
+#else
+	the_dispatcher = NULL;
+#endif
+	
+	// a dispatcher of a version we don't know, or a full one, is left alone:
+	//  we hook GetNextEvent ourselves, as if there were none
+	if (the_dispatcher == NULL || !CursorsDispatchRegister(the_dispatcher, CursorsRemapKey))
+	{
+		cursors_dispatcher.version = CURSORS_DISPATCH_VERSION;
+		cursors_dispatcher.handler[0] = CursorsRemapKey;
+		cursors_dispatcher.handler_count = 1;
+		cursors_owns_trap = true;
+		
+#if CURSORS_USE_GNE_FILTER
+		// the 64K ROM has no jGNEFilter, so the trap patch is all it gets
+		cursors_use_filter = (cursors_install_mode == INSTALL_MODE_GNE_FILTER && *(int16_t*)LM_ROM85 >= 0);
+#endif
+		CursorsHook();
+		
+#if CURSORS_USE_GESTALT
+		// publish for INITs that load after us. if Gestalt is missing (pre 6.0.4),
+		//  or the selector is taken, we just run as a private dispatcher
+		if (CursorsGestaltAvailable())
+		{
+			NewGestalt(CURSORS_DISPATCH_SELECTOR, (ProcPtr)CursorsGestalt);
+		}
+#endif
+	}
+	
+#if CURSORS_USE_GESTALT
+	// companion apps can push a new mapping at runtime from here on
+	if (CursorsGestaltAvailable())
+	{
+		cursors_keymap_interface.version = CURSORS_KEYMAP_VERSION;
+		cursors_keymap_interface.set_keymap = CursorsSetKeymap;
+		cursors_keymap_interface.get_keymap = CursorsGetKeymap;
+		NewGestalt(CURSORS_KEYMAP_SELECTOR, (ProcPtr)CursorsGestalt);
+	}
+#endif
+	
+#if CURSORS_USE_JOURNAL
+	// ring buffer is allocated now, while it is cheap; the event path never
+	//  allocates. journal file lives in the System Folder
+	if (CursorsGestaltAvailable())
+	{
+		SysEnvirons(curSysEnvVers, &world);
+		
+		if (CursorsJournalInit(world.sysVRefNum, (ProcPtr)CursorsJournalCompletion, cursors_owns_trap) == noErr)
+		{
+			cursors_journal_interface.version = CURSORS_JOURNAL_VERSION;
+			cursors_journal_interface.start_recording = CursorsStartRecording;
+			cursors_journal_interface.stop_recording = CursorsStopRecording;
+			cursors_journal_interface.start_playback = CursorsStartPlayback;
+			NewGestalt(CURSORS_JOURNAL_SELECTOR, (ProcPtr)CursorsGestalt);
+		}
+	}
+#endif
+	
+#if CURSORS_USE_TELEMETRY
+	// if the port can't be opened, we just run without telemetry
+	CursorsTelemetryInit((ProcPtr)CursorsTelemetryCompletion);
+#endif
+	
+#if CURSORS_SHOW_ICON
+	ShowInitIcon(ICON_ID, true);
+#endif
+	
+	RestoreA4();
+}
+
+
+// Moves the code to a low, non-relocatable block in the system heap and
+//  installs from there
 void main(void)
 {
 	Handle		myHandle;
 	Ptr			myPtr;
-	SysEnvRec	world;
+	Ptr			resident_ptr;
+	Ptr			install_ptr;
+#if CURSORS_USE_CODE_COPY
+	Size		code_size;
+#endif
 	Str255*		namePtr;
 
 	// LOGIC:
 	//  This block is called once. It saves the pointer
 	//   to this code resource, and installs the patch.
+	//  By default the code is detached and stays, locked, wherever the
+	//   Resource Manager loaded it.
+	//  With CURSORS_USE_CODE_COPY, it is copied into a NewPtrSys block and
+	//   installed from there, and the resource is freed with the INIT file.
+	//   The copy lands low, but NewPtrSys makes room by moving unlocked
+	//   handles up, and the ones that end up above a locked block stay there.
+	//   in tools/heap_sim, with the full INIT's size from make matrix (5268
+	//   bytes), the largest free block after boot was 46059 bytes on average
+	//   copied against 45068 detached, better in 542 of 1000 boots and worse
+	//   in 311. But the worst boot fell from 12606 to 12136 bytes, and below
+	//   about 4.5K of code the copy loses on average too. The host size is
+	//   not the 68k size, so which side of that line the INIT is on is not
+	//   known. The copy is off: it costs room for a second copy at boot and
+	//   makes the worst case worse, for a gain that depends on the size.
+	//  If there isn't room for the copy, it falls back to detaching in place.
 
 	asm
 	{
@@ -314,20 +1301,42 @@ void main(void)
  	
  	if(!Button()) 
  	{
- 		myHandle = RecoverHandle(myPtr); 		
-		DetachResource(myHandle);
-
- 		cursors_origGetNextEventAddr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
-		NSetTrapAddress((long)NewGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+ 		myHandle = RecoverHandle(myPtr);
+		resident_ptr = NULL;
+		
+#if CURSORS_USE_CODE_COPY
+ 		code_size = GetHandleSize(myHandle);
+		resident_ptr = NewPtrSys(code_size);
+		
+		if (resident_ptr != NULL)
+		{
+			BlockMove(myPtr, resident_ptr, code_size);
+			
+			// 68020 and up: make sure the CPU doesn't run stale cache for the copy.
+			//  the 64K ROM has neither a cache nor NGetTrapAddress
+			if (*(int16_t*)LM_ROM85 >= 0 && NGetTrapAddress((int)HWPrivTrap, OSTrap) != NGetTrapAddress((int)UnimplementedTrap, ToolTrap))
+			{
+				CursorsFlushCodeCache();
+			}
+		}
+#endif
 		
-		ShowInitIcon(ICON_ID, true);
+		if (resident_ptr == NULL)
+		{
+			DetachResource(myHandle);
+			resident_ptr = myPtr;
+		}
+		
+		// same function, but in whichever copy is staying resident
+		install_ptr = resident_ptr + ((Ptr)CursorsInstall - myPtr);
+		
+		asm
+		{
+			movea.l resident_ptr, A0
+			movea.l install_ptr, A1
+			jsr (A1)
+		}
 	}
 	
 	RestoreA4();
 }
-
-
-
-
-
-
@@ -0,0 +1,376 @@
+/*
+ * dispatch_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of N keyboard INITs loading at boot, each one either
+ *  joining the shared dispatcher (cursors_dispatch.c, the same code the INIT
+ *  runs) or patching GetNextEvent on its own. Counts how many patches every
+ *  GetNextEvent call goes through, and checks that every handler sees every
+ *  key event exactly once, in load order.
+ *
+ * Usage: dispatch_sim
+ *   prints one row per N and exits non-zero if any check fails.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_dispatch.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIM_MAX_INITS				(CURSORS_DISPATCH_MAX_HANDLERS + 2)
+#define SIM_NUM_EVENTS				1000
+#define SIM_KEY_EVERY				4		// 1 in 4 simulated events is a key event
+
+#define SIM_INIT_COOPERATING		0		// looks for the dispatcher before patching
+#define SIM_INIT_LEGACY				1		// always patches GetNextEvent itself
+#define SIM_INIT_FUTURE				2		// cooperating, but publishes a newer dispatcher version
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+// one patch on the simulated GetNextEvent trap. patches are tail patches, like
+//  ours: call down the chain first, then look at the event
+typedef struct SimPatch
+{
+	CursorsDispatcher*			dispatcher;	// dispatcher patch: run these handlers
+	CursorsKeyHandlerProcPtr	handler;	// legacy patch: run just this one
+} SimPatch;
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static SimPatch				sim_trap_chain[SIM_MAX_INITS];	// [0] is closest to the ROM
+static int					sim_trap_chain_length;
+static CursorsDispatcher*	sim_gestalt_dispatcher;			// what 'CCkd' returns, or NULL
+static CursorsDispatcher	sim_dispatchers[SIM_MAX_INITS];	// one per INIT that ends up owning one
+
+static int					sim_hops;						// patches entered by this GetNextEvent call
+static int					sim_handler_runs[SIM_MAX_INITS];	// per INIT, this event
+static int					sim_handler_order[SIM_MAX_INITS];
+static int					sim_handler_order_count;
+static int					sim_swallow_init = -1;			// INIT whose handler swallows key events
+
+static int					sim_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// One key handler per simulated INIT: records that it ran
+static void SimHandlerRan(int init_index, EventRecord *theEvent);
+
+// Loads one simulated INIT, the way its kind of INIT installs itself
+static void SimLoadInit(int init_index, int init_kind);
+
+// The simulated GetNextEvent trap: enters every patch on the chain
+static bool SimGetNextEvent(int patch_index, EventRecord *theEvent, int16_t what);
+
+// Boots N INITs, runs SIM_NUM_EVENTS through GetNextEvent, checks the results
+// @return	Returns the most patches any one GetNextEvent call went through
+static int SimRun(int num_inits, const int *init_kinds);
+
+static void SimCheck(bool condition, const char *what, int num_inits);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+#define SIM_HANDLER(n)	static pascal void SimHandler##n(EventRecord *theEvent) { SimHandlerRan(n, theEvent); }
+SIM_HANDLER(0) SIM_HANDLER(1) SIM_HANDLER(2) SIM_HANDLER(3) SIM_HANDLER(4)
+SIM_HANDLER(5) SIM_HANDLER(6) SIM_HANDLER(7) SIM_HANDLER(8) SIM_HANDLER(9)
+
+static const CursorsKeyHandlerProcPtr	sim_handlers[SIM_MAX_INITS] =
+{
+	SimHandler0, SimHandler1, SimHandler2, SimHandler3, SimHandler4,
+	SimHandler5, SimHandler6, SimHandler7, SimHandler8, SimHandler9,
+};
+
+
+// One key handler per simulated INIT: records that it ran
+static void SimHandlerRan(int init_index, EventRecord *theEvent)
+{
+	sim_handler_runs[init_index]++;
+	sim_handler_order[sim_handler_order_count++] = init_index;
+
+	if (init_index == sim_swallow_init)
+	{
+		theEvent->what = nullEvent;
+	}
+}
+
+
+// Loads one simulated INIT, the way its kind of INIT installs itself
+static void SimLoadInit(int init_index, int init_kind)
+{
+	CursorsDispatcher*	the_dispatcher;
+	SimPatch*			the_patch;
+
+	// LOGIC:
+	//   same decision as CursorsInstall(): join the published dispatcher if
+	//   CursorsDispatchRegister() accepts it, otherwise patch the trap, and
+	//   publish our own dispatcher if the Gestalt selector is still free
+
+	if (init_kind != SIM_INIT_LEGACY && sim_gestalt_dispatcher != NULL)
+	{
+		if (CursorsDispatchRegister(sim_gestalt_dispatcher, sim_handlers[init_index]))
+		{
+			return;
+		}
+	}
+
+	the_patch = &sim_trap_chain[sim_trap_chain_length++];
+	memset(the_patch, 0, sizeof(SimPatch));
+
+	if (init_kind == SIM_INIT_LEGACY)
+	{
+		the_patch->handler = sim_handlers[init_index];
+		return;
+	}
+
+	the_dispatcher = &sim_dispatchers[init_index];
+	the_dispatcher->version = (init_kind == SIM_INIT_FUTURE) ? CURSORS_DISPATCH_VERSION + 1 : CURSORS_DISPATCH_VERSION;
+	the_dispatcher->handler[0] = sim_handlers[init_index];
+	the_dispatcher->handler_count = 1;
+	the_patch->dispatcher = the_dispatcher;
+
+	if (sim_gestalt_dispatcher == NULL)
+	{
+		sim_gestalt_dispatcher = the_dispatcher;
+	}
+}
+
+
+// The simulated GetNextEvent trap: enters every patch on the chain
+static bool SimGetNextEvent(int patch_index, EventRecord *theEvent, int16_t what)
+{
+	SimPatch*	the_patch;
+	bool		event_needs_action;
+
+	if (patch_index < 0)
+	{
+		// the ROM: hands out the next scripted event
+		memset(theEvent, 0, sizeof(EventRecord));
+		theEvent->what = what;
+		theEvent->message = 0x1E18;
+		return (what != nullEvent);
+	}
+
+	sim_hops++;
+	the_patch = &sim_trap_chain[patch_index];
+	event_needs_action = SimGetNextEvent(patch_index - 1, theEvent, what);
+
+	if (event_needs_action && (theEvent->what == keyDown || theEvent->what == autoKey))
+	{
+		if (the_patch->dispatcher != NULL)
+		{
+			if (CursorsDispatchKey(the_patch->dispatcher, theEvent))
+			{
+				event_needs_action = false;
+			}
+		}
+		else
+		{
+			(*the_patch->handler)(theEvent);
+
+			if (theEvent->what == nullEvent)
+			{
+				event_needs_action = false;
+			}
+		}
+	}
+
+	return event_needs_action;
+}
+
+
+// Boots N INITs, runs SIM_NUM_EVENTS through GetNextEvent, checks the results
+// @return	Returns the most patches any one GetNextEvent call went through
+static int SimRun(int num_inits, const int *init_kinds)
+{
+	EventRecord	the_event;
+	int16_t		what;
+	int			i;
+	int			n;
+	int			max_hops = 0;
+	int			expected_runs;
+	bool		event_needs_action;
+	bool		order_ok;
+
+	sim_trap_chain_length = 0;
+	sim_gestalt_dispatcher = NULL;
+	memset(sim_dispatchers, 0, sizeof(sim_dispatchers));
+
+	for (i = 0; i < num_inits; i++)
+	{
+		SimLoadInit(i, init_kinds[i]);
+	}
+
+	for (n = 0; n < SIM_NUM_EVENTS; n++)
+	{
+		what = (n % SIM_KEY_EVERY == 0) ? ((n & 1) ? autoKey : keyDown) : ((n % 3 == 0) ? mouseDown : nullEvent);
+
+		sim_hops = 0;
+		sim_handler_order_count = 0;
+		memset(sim_handler_runs, 0, sizeof(sim_handler_runs));
+
+		event_needs_action = SimGetNextEvent(sim_trap_chain_length - 1, &the_event, what);
+
+		if (sim_hops > max_hops)
+		{
+			max_hops = sim_hops;
+		}
+
+		// every handler up to (and including) a swallowing one runs once per key event
+		for (i = 0; i < num_inits; i++)
+		{
+			expected_runs = (what == keyDown || what == autoKey) ? 1 : 0;
+
+			if (sim_swallow_init >= 0 && sim_swallow_init < num_inits && i > sim_swallow_init)
+			{
+				expected_runs = 0;
+			}
+
+			SimCheck(sim_handler_runs[i] == expected_runs, "handler ran once per key event", num_inits);
+		}
+
+		// and in the order the INITs loaded
+		order_ok = true;
+
+		for (i = 1; i < sim_handler_order_count; i++)
+		{
+			if (sim_handler_order[i] <= sim_handler_order[i - 1])
+			{
+				order_ok = false;
+			}
+		}
+
+		SimCheck(order_ok, "handlers run in load order", num_inits);
+
+		if (sim_swallow_init >= 0 && sim_swallow_init < num_inits && (what == keyDown || what == autoKey))
+		{
+			SimCheck(!event_needs_action && the_event.what == nullEvent, "swallowed event returns false", num_inits);
+		}
+		else
+		{
+			SimCheck(event_needs_action == (what != nullEvent), "result passed through", num_inits);
+		}
+	}
+
+	return max_hops;
+}
+
+
+static void SimCheck(bool condition, const char *what, int num_inits)
+{
+	if (!condition)
+	{
+		// one line per failure kind would do, but every one is a real bug
+		if (sim_failures < 20)
+		{
+			fprintf(stderr, "FAIL (N=%d): %s\n", num_inits, what);
+		}
+
+		sim_failures++;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(void)
+{
+	int		kinds[SIM_MAX_INITS];
+	int		num_inits;
+	int		cooperating_hops;
+	int		legacy_hops;
+	int		i;
+
+	printf("INITs  cooperating: patches/call  legacy: patches/call\n");
+
+	for (num_inits = 1; num_inits <= SIM_MAX_INITS; num_inits++)
+	{
+		for (i = 0; i < num_inits; i++)
+		{
+			kinds[i] = SIM_INIT_COOPERATING;
+		}
+
+		cooperating_hops = SimRun(num_inits, kinds);
+
+		for (i = 0; i < num_inits; i++)
+		{
+			kinds[i] = SIM_INIT_LEGACY;
+		}
+
+		legacy_hops = SimRun(num_inits, kinds);
+
+		printf("%5d  %25d  %20d\n", num_inits, cooperating_hops, legacy_hops);
+
+		// one hop while the dispatcher has room; one more for each INIT past that
+		if (num_inits <= CURSORS_DISPATCH_MAX_HANDLERS)
+		{
+			SimCheck(cooperating_hops == 1, "chain length stays at 1", num_inits);
+		}
+		else
+		{
+			SimCheck(cooperating_hops == 1 + num_inits - CURSORS_DISPATCH_MAX_HANDLERS, "full dispatcher: extra INITs patch", num_inits);
+		}
+
+		SimCheck(legacy_hops == num_inits, "legacy chain grows by one per INIT", num_inits);
+	}
+
+	// a dispatcher of a version we don't know is never written to
+	kinds[0] = SIM_INIT_FUTURE;
+	kinds[1] = SIM_INIT_COOPERATING;
+	kinds[2] = SIM_INIT_COOPERATING;
+	SimCheck(SimRun(3, kinds) == 3, "unknown dispatcher version: patch instead of joining", 3);
+	SimCheck(sim_dispatchers[0].handler_count == 1, "unknown dispatcher version left untouched", 3);
+
+	// a handler that swallows the event stops the ones after it
+	for (i = 0; i < 5; i++)
+	{
+		kinds[i] = SIM_INIT_COOPERATING;
+	}
+
+	sim_swallow_init = 2;
+	SimRun(5, kinds);
+	sim_swallow_init = -1;
+
+	if (sim_failures > 0)
+	{
+		fprintf(stderr, "dispatch_sim: %d check(s) failed\n", sim_failures);
+		return 1;
+	}
+
+	printf("dispatch_sim: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,464 @@
+/*
+ * filter_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of the two install modes: the GetNextEvent trap patch and
+ *  the jGNEFilter hook. Builds custom_cursors.c against the fake Mac in
+ *  host/toolbox_host.c and installs it as a trap patch. The filter's asm
+ *  entry (CursorsGNEFilter) is stripped on the host, so the simulation plays
+ *  the Event Manager and calls its C side, CursorsFilterEvent(), the way the
+ *  entry would.
+ *
+ * First it checks the filter against EventAvail: an app that peeks at a key
+ *  event and then takes it must see the same event both times. The handlers,
+ *  the repeat state and the journal must see it only once, and that must also
+ *  hold when a handler swallows the event.
+ *
+ * Then it runs the same keys through both modes for three kinds of app. One
+ *  calls GetNextEvent, one only calls WaitNextEvent (which, under
+ *  MultiFinder, never goes through the GetNextEvent trap), and one peeks with
+ *  EventAvail before each GetNextEvent. It prints how many keys each app got
+ *  remapped, and host time per event for the GetNextEvent app.
+ *
+ * The host times cover the C part of each mode only. The 68k glue, which is
+ *  the trap dispatch into the patch and CallPascalB in one mode and the
+ *  register shuffling of CursorsGNEFilter in the other, is not run here.
+ *  Without a 68k emulator there are no cycle counts for it.
+ *
+ * Usage: filter_sim [events]     (default 100000 per timing)
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// the INIT itself. its main() is the code resource entry point, not ours
+#define main	CursorsMain
+#include "custom_cursors.c"
+#undef main
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIM_EVERY_EVENT				-1
+#define SIM_DEFAULT_EVENTS			100000
+#define SIM_BENCH_RUNS				21		// best of
+#define SIM_COVERAGE_KEYS			40
+#define SIM_SWALLOWED_KEY			0x12	// the counting handler swallows this key
+
+#define SIM_MODE_TRAP				0
+#define SIM_MODE_FILTER				1
+#define NUM_SIM_MODES				2
+
+#define SIM_APP_GNE					0		// GetNextEvent
+#define SIM_APP_WNE					1		// WaitNextEvent only, under MultiFinder
+#define SIM_APP_PEEK				2		// EventAvail, then GetNextEvent
+#define NUM_SIM_APPS				3
+
+#define SIM_CHECK(condition, what)	SimCheck((condition), (what), __LINE__)
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// "\pCustom Cursors Journal", as the host compiler can't write \p
+static uint8_t			sim_journal_name[] = "\026Custom Cursors Journal";
+
+static const char*		sim_mode_name[NUM_SIM_MODES] =
+{
+	"trap patch",
+	"jGNEFilter",
+};
+
+static const char*		sim_app_name[NUM_SIM_APPS] =
+{
+	"GetNextEvent",
+	"WaitNextEvent",
+	"EventAvail+GNE",
+};
+
+static EventRecord		sim_next_event;		// what the "ROM" hands out
+static long				sim_trap_addr;		// the patched GetNextEvent
+static int				sim_mode;			// which one the simulated Event Manager runs
+static int32_t			sim_handler_runs = 0;
+static int				sim_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent);
+
+// Another INIT's key handler, registered after ours: counts its calls and
+//  swallows one key
+static pascal void SimCountingHandler(EventRecord *theEvent);
+
+// Sets up the next key event the ROM hands out
+static void SimScriptKey(uint8_t key, bool with_capslock, int32_t when);
+
+// GetNextEvent, as the app calls it, in the current mode
+static Boolean SimGetNextEvent(EventRecord *theEvent);
+
+// WaitNextEvent under MultiFinder: the Event Manager's internals and the
+//  filter, but not the GetNextEvent trap
+static Boolean SimWaitNextEvent(EventRecord *theEvent);
+
+// EventAvail: the filter runs, the trap patch doesn't, the event stays queued
+static Boolean SimEventAvail(EventRecord *theEvent);
+
+// Checks the filter against an app that peeks before it takes
+static void SimPeekTests(void);
+
+// Runs keys through one app in one mode
+// @return	Returns the number of keys the app got remapped
+static int SimCoverage(int mode, int app);
+
+// @return	Returns the fastest host ns per event through GetNextEvent in one mode, minus the bare ROM
+static double SimBench(int mode, long num_events);
+
+static void SimCheck(bool condition, const char *what, int line);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent)
+{
+	*theEvent = sim_next_event;
+	return (theEvent->what != nullEvent);
+}
+
+
+// Another INIT's key handler, registered after ours: counts its calls and
+//  swallows one key
+static pascal void SimCountingHandler(EventRecord *theEvent)
+{
+	sim_handler_runs++;
+
+	if (((theEvent->message & keyCodeMask) >> 8) == SIM_SWALLOWED_KEY)
+	{
+		theEvent->what = nullEvent;
+	}
+}
+
+
+// Sets up the next key event the ROM hands out
+static void SimScriptKey(uint8_t key, bool with_capslock, int32_t when)
+{
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	sim_next_event.what = keyDown;
+	sim_next_event.message = (key << 8) | 'k';
+	sim_next_event.when = when;
+	sim_next_event.modifiers = with_capslock ? alphaLock : 0;
+}
+
+
+// GetNextEvent, as the app calls it, in the current mode
+static Boolean SimGetNextEvent(EventRecord *theEvent)
+{
+	if (sim_mode == SIM_MODE_TRAP)
+	{
+		return CallPascalB(SIM_EVERY_EVENT, theEvent, sim_trap_addr);
+	}
+
+	// the ROM's GetNextEvent, then the filter on what it got
+	return CursorsFilterEvent(SimROMGetNextEvent(SIM_EVERY_EVENT, theEvent), theEvent);
+}
+
+
+// WaitNextEvent under MultiFinder: the Event Manager's internals and the
+//  filter, but not the GetNextEvent trap
+static Boolean SimWaitNextEvent(EventRecord *theEvent)
+{
+	if (sim_mode == SIM_MODE_TRAP)
+	{
+		return SimROMGetNextEvent(SIM_EVERY_EVENT, theEvent);
+	}
+
+	return CursorsFilterEvent(SimROMGetNextEvent(SIM_EVERY_EVENT, theEvent), theEvent);
+}
+
+
+// EventAvail: the filter runs, the trap patch doesn't, the event stays queued
+static Boolean SimEventAvail(EventRecord *theEvent)
+{
+	return SimWaitNextEvent(theEvent);
+}
+
+
+// Checks the filter against an app that peeks before it takes
+static void SimPeekTests(void)
+{
+	EventRecord			peeked;
+	EventRecord			taken;
+	CursorsRemapState	state_after_peek;
+	Boolean				peek_result;
+	Boolean				take_result;
+	const uint8_t*		contents;
+	int32_t				size;
+
+	sim_mode = SIM_MODE_FILTER;
+	sim_handler_runs = 0;
+	SIM_CHECK(CursorsStartRecording() == noErr, "start recording");
+
+	// a remapped key: peeked, then taken
+	SimScriptKey(cursors_key[0], true, 100);
+	peek_result = SimEventAvail(&peeked);
+	state_after_peek = cursors_remap_state;
+	take_result = SimGetNextEvent(&taken);
+
+	SIM_CHECK(peek_result && take_result && memcmp(&peeked, &taken, sizeof(EventRecord)) == 0, "peek and take see the same event");
+	SIM_CHECK((taken.message & 0xFFFF) == cursors_remap[0], "and it is remapped");
+	SIM_CHECK(sim_handler_runs == 1, "handlers ran once for a peeked key");
+	SIM_CHECK(memcmp(&state_after_peek, &cursors_remap_state, sizeof(CursorsRemapState)) == 0, "repeat state left alone by the take");
+
+	// peeked twice: still once
+	SimScriptKey(0x2F, false, 101);
+	SimEventAvail(&peeked);
+	SimEventAvail(&peeked);
+	SimGetNextEvent(&taken);
+	SIM_CHECK(sim_handler_runs == 2 && memcmp(&peeked, &taken, sizeof(EventRecord)) == 0, "handlers ran once for a key peeked twice");
+
+	// the same key repeating is a new event: a later tick
+	SimScriptKey(0x2F, false, 105);
+	sim_next_event.what = autoKey;
+	SimGetNextEvent(&taken);
+	SIM_CHECK(sim_handler_runs == 3, "a repeat of the same key is a new event");
+
+	// swallowed on the peek: swallowed on the take too, not run again
+	SimScriptKey(SIM_SWALLOWED_KEY, false, 110);
+	peek_result = SimEventAvail(&peeked);
+	take_result = SimGetNextEvent(&taken);
+	SIM_CHECK(!peek_result && !take_result && taken.what == nullEvent && sim_handler_runs == 4, "swallowed once, for peek and take");
+
+	// without a peek, every key still goes through
+	SimScriptKey(cursors_key[1], true, 111);
+	SimGetNextEvent(&taken);
+	SIM_CHECK(sim_handler_runs == 5 && (taken.message & 0xFFFF) == cursors_remap[1], "a key taken without a peek");
+
+	// the journal has each key the app got once
+	SIM_CHECK(CursorsStopRecording() == noErr, "stop recording");
+	contents = HostFileContents(sim_journal_name, &size);
+	SIM_CHECK(contents != NULL && size == 4 * (int32_t)sizeof(EventRecord), "journal has each delivered key once");
+}
+
+
+// Runs keys through one app in one mode
+// @return	Returns the number of keys the app got remapped
+static int SimCoverage(int mode, int app)
+{
+	EventRecord		the_event;
+	EventRecord		peeked;
+	Boolean			event_needs_action;
+	int32_t			runs_before = sim_handler_runs;
+	int				remapped = 0;
+	int				i;
+
+	sim_mode = mode;
+
+	for (i = 0; i < SIM_COVERAGE_KEYS; i++)
+	{
+		SimScriptKey(cursors_key[i & 3], true, 1000 + mode * 100000 + app * 10000 + i);
+
+		switch (app)
+		{
+			case SIM_APP_GNE:
+				event_needs_action = SimGetNextEvent(&the_event);
+				break;
+
+			case SIM_APP_WNE:
+				event_needs_action = SimWaitNextEvent(&the_event);
+				break;
+
+			default:
+				SimEventAvail(&peeked);
+				event_needs_action = SimGetNextEvent(&the_event);
+				break;
+		}
+
+		if (event_needs_action && (the_event.message & 0xFFFF) == cursors_remap[i & 3])
+		{
+			remapped++;
+		}
+	}
+
+	// in every mode and app, a key the INIT sees goes through the handlers once
+	if (remapped > 0)
+	{
+		SIM_CHECK(sim_handler_runs - runs_before == SIM_COVERAGE_KEYS, "handlers ran once per key");
+	}
+
+	return remapped;
+}
+
+
+// @return	Returns the fastest host ns per event through GetNextEvent in one mode, minus the bare ROM
+static double SimBench(int mode, long num_events)
+{
+	EventRecord			the_event;
+	struct timespec		start;
+	struct timespec		end;
+	double				ns[2];
+	double				best[2] = {0, 0};
+	long				n;
+	int					run;
+	int					bare;
+
+	sim_mode = mode;
+	SimScriptKey(0x2F, false, 0);
+
+	for (run = 0; run < SIM_BENCH_RUNS; run++)
+	{
+		for (bare = 0; bare < 2; bare++)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &start);
+
+			for (n = 0; n < num_events; n++)
+			{
+				// a new tick every event, so the filter never takes it for a peek
+				sim_next_event.when = n;
+
+				if (bare)
+				{
+					SimROMGetNextEvent(SIM_EVERY_EVENT, &the_event);
+				}
+				else
+				{
+					SimGetNextEvent(&the_event);
+				}
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &end);
+
+			ns[bare] = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / num_events;
+
+			if (run == 0 || ns[bare] < best[bare])
+			{
+				best[bare] = ns[bare];
+			}
+		}
+	}
+
+	return best[0] - best[1];
+}
+
+
+static void SimCheck(bool condition, const char *what, int line)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAIL (line %d): %s\n", line, what);
+		sim_failures++;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	int		remapped[NUM_SIM_MODES][NUM_SIM_APPS];
+	long	num_events = SIM_DEFAULT_EVENTS;
+	int		mode;
+	int		app;
+
+	if (argc > 1)
+	{
+		num_events = atol(argv[1]);
+	}
+
+	if (!HostCheckAddresses())
+	{
+		fprintf(stderr, "filter_sim: addresses don't fit in 32 bits; link with -no-pie\n");
+		return 1;
+	}
+
+	// a System with Gestalt, so the journal is installed
+	HostResetToolbox();
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)Gestalt, (int)GestaltTrap, OSTrap);
+
+	CursorsInstall();
+	sim_trap_addr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+
+	if (sim_trap_addr != (long)NewGetNextEvent || !CursorsDispatchRegister(&cursors_dispatcher, SimCountingHandler))
+	{
+		fprintf(stderr, "filter_sim: CursorsInstall() did not patch GetNextEvent\n");
+		return 1;
+	}
+
+	SimPeekTests();
+
+	printf("%-16s", "keys remapped");
+
+	for (app = 0; app < NUM_SIM_APPS; app++)
+	{
+		printf(" %16s", sim_app_name[app]);
+	}
+
+	printf("   (of %d)\n", SIM_COVERAGE_KEYS);
+
+	for (mode = 0; mode < NUM_SIM_MODES; mode++)
+	{
+		printf("%-16s", sim_mode_name[mode]);
+
+		for (app = 0; app < NUM_SIM_APPS; app++)
+		{
+			remapped[mode][app] = SimCoverage(mode, app);
+			printf(" %16d", remapped[mode][app]);
+		}
+
+		printf("\n");
+	}
+
+	SIM_CHECK(remapped[SIM_MODE_TRAP][SIM_APP_GNE] == SIM_COVERAGE_KEYS && remapped[SIM_MODE_TRAP][SIM_APP_PEEK] == SIM_COVERAGE_KEYS, "trap patch remaps GetNextEvent apps");
+	SIM_CHECK(remapped[SIM_MODE_TRAP][SIM_APP_WNE] == 0, "trap patch misses WaitNextEvent apps under MultiFinder");
+
+	for (app = 0; app < NUM_SIM_APPS; app++)
+	{
+		SIM_CHECK(remapped[SIM_MODE_FILTER][app] == SIM_COVERAGE_KEYS, "jGNEFilter remaps every app");
+	}
+
+	printf("\nhost ns/event over the bare GetNextEvent, other key, C part only\n");
+
+	for (mode = 0; mode < NUM_SIM_MODES; mode++)
+	{
+		printf("%-16s %8.2f\n", sim_mode_name[mode], SimBench(mode, num_events));
+	}
+
+	if (sim_failures > 0)
+	{
+		fprintf(stderr, "filter_sim: %d check(s) FAILED\n", sim_failures);
+		return 1;
+	}
+
+	printf("filter_sim: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,852 @@
+/*
+ * heap_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of the system heap at boot. It compares the two ways
+ *  main() can leave the INIT resident: the default, detaching the resource
+ *  where the Resource Manager loaded it, and CURSORS_USE_CODE_COPY, copying
+ *  the code into a NewPtrSys block.
+ *
+ * The heap is a model, not the real Memory Manager. It follows the rules
+ *  from Inside Macintosh II that matter here:
+ *  - a relocatable block goes in the lowest free block it fits in. If none
+ *    fits, the heap is compacted first.
+ *  - a non-relocatable block goes as low as the Memory Manager can make
+ *    room, moving unlocked relocatable blocks up out of its way.
+ *  - compaction slides unlocked relocatable blocks down. It never moves
+ *    non-relocatable or locked blocks: those are islands.
+ *  The heap has a fixed size, with no block headers, no purging and no
+ *  growing into the application zone.
+ *
+ * Each simulated boot fills the heap as System 6 on a small Mac would:
+ *  - the System's own low block, its resources and drivers (some locked),
+ *    and holes where resources were released.
+ *  - a few INITs before and after ours. Each loads its code and icon, leaves
+ *    something resident (a NewPtrSys block, its code detached in place, or a
+ *    handle) and allocates and frees some temporary blocks. INIT 31 then
+ *    closes its file, which releases the resources it did not detach.
+ *  - our INIT: the ICN# and the code resource are loaded, and the code stays
+ *    locked while it runs. Then it either detaches in place, or copies itself
+ *    low and leaves the resource to be freed with the file. Also, today
+ *    DrawBWIcon releases the ICN# as soon as it has drawn it, where the old
+ *    code left it locked until the file closed.
+ *
+ * Every boot is run twice from the same random seed, once for each install.
+ *  Both runs make the same allocations in the same order. The simulation
+ *  reports the largest block an application could get after boot (the
+ *  largest free block after compaction, as MaxBlock would say), together
+ *  with the same figure just before our INIT loads, and in how many boots
+ *  the copy left more or less than detaching. It fails if the model's heap
+ *  ever breaks, or the two runs of a boot differ before our INIT loads.
+ *
+ * In this model the copy lands low, but to make room NewPtrSys moves
+ *  unlocked handles up, and some end up above a locked block, where
+ *  compaction can't bring them back down. What that costs depends on the
+ *  code size. At the full INIT's 5268 bytes the copy leaves about 1K more on
+ *  average, but a smaller worst case. Below about 4.5K it loses on average
+ *  too; at 4184 bytes it came out even, and so did copying high (a locked
+ *  handle moved up with MoveHHi) and keeping the copy only when it landed
+ *  below the resource.
+ *
+ * Usage: heap_sim [boots] [code bytes]   (default 1000 boots. The code size
+ *  defaults to the full INIT's code and globals, as make matrix reports
+ *  them, when heap_sim is built by make; built any other way, it must be
+ *  given)
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define HEAP_SIZE					(112 * 1024)	// a System 6 system heap on a 1MB Mac
+#define HEAP_MAX_BLOCKS				512
+#define HEAP_NO_BLOCK				-1
+
+#define HEAP_DEFAULT_BOOTS			1000
+#define HEAP_ICON_SIZE				256			// one ICN#: icon and mask
+
+// make passes the "full" total from variant_matrix.sh -s. 0: no default
+#ifndef HEAP_DEFAULT_CODE_SIZE
+	#define HEAP_DEFAULT_CODE_SIZE	0
+#endif
+
+#define HEAP_INSTALL_DETACH			0			// DetachResource in place, the default
+#define HEAP_INSTALL_COPY			1			// NewPtrSys copy, CURSORS_USE_CODE_COPY
+#define NUM_HEAP_INSTALLS			2
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+typedef enum HeapBlockKind
+{
+	BLOCK_FREE = 0,
+	BLOCK_PTR,							// non-relocatable
+	BLOCK_HANDLE,						// relocatable
+} HeapBlockKind;
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct HeapBlock
+{
+	int32_t			start;
+	int32_t			size;
+	HeapBlockKind	kind;
+	bool			locked;				// handles only
+	int16_t			id;					// stays the same when a handle moves
+} HeapBlock;
+
+// blocks in address order, tiling the heap with no gaps
+typedef struct Heap
+{
+	HeapBlock		block[HEAP_MAX_BLOCKS];
+	int				num_blocks;
+	int16_t			next_id;
+} Heap;
+
+typedef struct HeapBootResult
+{
+	int32_t			before;				// largest free block just before our INIT loads
+	int32_t			after;				// largest free block after boot
+	bool			copied;				// the copy got its block (HEAP_INSTALL_COPY only)
+} HeapBootResult;
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static const char*		heap_install_name[NUM_HEAP_INSTALLS] =
+{
+	"detach in place",
+	"NewPtrSys copy",
+};
+
+static uint32_t			heap_random;
+static int				heap_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Small LCG, so both installs see the same boot
+static uint32_t HeapRandom(void);
+
+// @return	Returns a random number from low to high, both included, rounded to even
+static int32_t HeapRandomSize(int32_t low, int32_t high);
+
+static void HeapInit(Heap *heap);
+
+// Checks that the blocks tile the heap, and counts a failure if not
+static void HeapCheck(const Heap *heap, const char *after);
+
+// @return	Returns the index of the block with this id, or HEAP_NO_BLOCK
+static int HeapFind(const Heap *heap, int16_t id);
+
+// Makes room for one more block after index i
+static void HeapInsertAfter(Heap *heap, int i);
+
+// Joins neighbouring free blocks
+static void HeapMergeFree(Heap *heap);
+
+// Turns the low end of free block i into an allocated block
+// @return	Returns the new block's id
+static int16_t HeapCarve(Heap *heap, int i, int32_t size, HeapBlockKind kind);
+
+// Slides every unlocked handle down as far as it goes
+static void HeapCompact(Heap *heap);
+
+// @return	Returns the index of the lowest free block of at least size, or HEAP_NO_BLOCK
+static int HeapFirstFit(const Heap *heap, int32_t size);
+
+// @return	Returns the new handle's id, or HEAP_NO_BLOCK if there is no room
+static int16_t HeapNewHandle(Heap *heap, int32_t size);
+
+// Puts a non-relocatable block as low as unlocked handles can be moved out of its way
+// @return	Returns the new block's id, or HEAP_NO_BLOCK if there is no room
+static int16_t HeapNewPtr(Heap *heap, int32_t size);
+
+// Tries to put a non-relocatable block at the start of block first
+// @return	Returns the new block's id, or HEAP_NO_BLOCK if the handles there can't be moved
+static int16_t HeapNewPtrAt(Heap *heap, int first, int32_t size);
+
+static void HeapDispose(Heap *heap, int16_t id);
+
+static void HeapSetLock(Heap *heap, int16_t id, bool locked);
+
+// @return	Returns the largest free block after compaction, as MaxBlock would
+static int32_t HeapMaxBlock(const Heap *heap);
+
+// One INIT other than ours: loads, leaves something resident, closes its file
+static void HeapOtherInit(Heap *heap);
+
+// One whole boot
+static HeapBootResult HeapBoot(uint32_t seed, int install, int32_t code_size);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Small LCG, so both installs see the same boot
+static uint32_t HeapRandom(void)
+{
+	heap_random = heap_random * 1103515245 + 12345;
+	return (heap_random >> 8);
+}
+
+
+// @return	Returns a random number from low to high, both included, rounded to even
+static int32_t HeapRandomSize(int32_t low, int32_t high)
+{
+	return (low + (int32_t)(HeapRandom() % (uint32_t)(high - low + 1))) & ~1;
+}
+
+
+static void HeapInit(Heap *heap)
+{
+	heap->num_blocks = 1;
+	heap->next_id = 0;
+	heap->block[0].start = 0;
+	heap->block[0].size = HEAP_SIZE;
+	heap->block[0].kind = BLOCK_FREE;
+	heap->block[0].locked = false;
+	heap->block[0].id = HEAP_NO_BLOCK;
+}
+
+
+// Checks that the blocks tile the heap, and counts a failure if not
+static void HeapCheck(const Heap *heap, const char *after)
+{
+	int32_t		next_start = 0;
+	int			i;
+
+	for (i = 0; i < heap->num_blocks; i++)
+	{
+		if (heap->block[i].start != next_start || heap->block[i].size <= 0)
+		{
+			fprintf(stderr, "FAIL: heap broken after %s, at block %d\n", after, i);
+			heap_failures++;
+			return;
+		}
+
+		next_start += heap->block[i].size;
+	}
+
+	if (next_start != HEAP_SIZE)
+	{
+		fprintf(stderr, "FAIL: heap broken after %s: blocks end at %d\n", after, next_start);
+		heap_failures++;
+	}
+}
+
+
+// @return	Returns the index of the block with this id, or HEAP_NO_BLOCK
+static int HeapFind(const Heap *heap, int16_t id)
+{
+	int		i;
+
+	for (i = 0; i < heap->num_blocks; i++)
+	{
+		if (heap->block[i].kind != BLOCK_FREE && heap->block[i].id == id)
+		{
+			return i;
+		}
+	}
+
+	return HEAP_NO_BLOCK;
+}
+
+
+// Makes room for one more block after index i
+static void HeapInsertAfter(Heap *heap, int i)
+{
+	memmove(&heap->block[i + 2], &heap->block[i + 1], (heap->num_blocks - i - 1) * sizeof(HeapBlock));
+	heap->num_blocks++;
+}
+
+
+// Joins neighbouring free blocks
+static void HeapMergeFree(Heap *heap)
+{
+	int		i = 0;
+
+	while (i < heap->num_blocks - 1)
+	{
+		if (heap->block[i].kind == BLOCK_FREE && heap->block[i + 1].kind == BLOCK_FREE)
+		{
+			heap->block[i].size += heap->block[i + 1].size;
+			memmove(&heap->block[i + 1], &heap->block[i + 2], (heap->num_blocks - i - 2) * sizeof(HeapBlock));
+			heap->num_blocks--;
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+
+// Turns the low end of free block i into an allocated block
+// @return	Returns the new block's id
+static int16_t HeapCarve(Heap *heap, int i, int32_t size, HeapBlockKind kind)
+{
+	HeapBlock*	the_block;
+
+	if (heap->block[i].size > size)
+	{
+		HeapInsertAfter(heap, i);
+		heap->block[i + 1].start = heap->block[i].start + size;
+		heap->block[i + 1].size = heap->block[i].size - size;
+		heap->block[i + 1].kind = BLOCK_FREE;
+		heap->block[i + 1].locked = false;
+		heap->block[i + 1].id = HEAP_NO_BLOCK;
+	}
+
+	the_block = &heap->block[i];
+	the_block->size = size;
+	the_block->kind = kind;
+	the_block->locked = false;
+	the_block->id = heap->next_id++;
+
+	return the_block->id;
+}
+
+
+// Slides every unlocked handle down as far as it goes
+static void HeapCompact(Heap *heap)
+{
+	HeapBlock	compacted[HEAP_MAX_BLOCKS];
+	HeapBlock*	the_block;
+	int32_t		next_start = 0;		// first byte not yet given to a block
+	int			num_compacted = 0;
+	int			i;
+
+	// LOGIC:
+	//   walk up the heap. an island stays where it is, with whatever gap is
+	//   left below it turned into one free block. an unlocked handle moves
+	//   down to the first free byte, which is never below the last island,
+	//   so it slides into the gap below it and never jumps an island
+
+	for (i = 0; i < heap->num_blocks; i++)
+	{
+		the_block = &heap->block[i];
+
+		if (the_block->kind == BLOCK_FREE)
+		{
+			continue;
+		}
+
+		if (the_block->kind == BLOCK_PTR || the_block->locked)
+		{
+			if (the_block->start > next_start)
+			{
+				compacted[num_compacted].start = next_start;
+				compacted[num_compacted].size = the_block->start - next_start;
+				compacted[num_compacted].kind = BLOCK_FREE;
+				compacted[num_compacted].locked = false;
+				compacted[num_compacted].id = HEAP_NO_BLOCK;
+				num_compacted++;
+			}
+
+			compacted[num_compacted++] = *the_block;
+		}
+		else
+		{
+			compacted[num_compacted] = *the_block;
+			compacted[num_compacted++].start = next_start;
+		}
+
+		next_start = compacted[num_compacted - 1].start + compacted[num_compacted - 1].size;
+	}
+
+	if (next_start < HEAP_SIZE)
+	{
+		compacted[num_compacted].start = next_start;
+		compacted[num_compacted].size = HEAP_SIZE - next_start;
+		compacted[num_compacted].kind = BLOCK_FREE;
+		compacted[num_compacted].locked = false;
+		compacted[num_compacted].id = HEAP_NO_BLOCK;
+		num_compacted++;
+	}
+
+	memcpy(heap->block, compacted, num_compacted * sizeof(HeapBlock));
+	heap->num_blocks = num_compacted;
+}
+
+
+// @return	Returns the index of the lowest free block of at least size, or HEAP_NO_BLOCK
+static int HeapFirstFit(const Heap *heap, int32_t size)
+{
+	int		i;
+
+	for (i = 0; i < heap->num_blocks; i++)
+	{
+		if (heap->block[i].kind == BLOCK_FREE && heap->block[i].size >= size)
+		{
+			return i;
+		}
+	}
+
+	return HEAP_NO_BLOCK;
+}
+
+
+// @return	Returns the new handle's id, or HEAP_NO_BLOCK if there is no room
+static int16_t HeapNewHandle(Heap *heap, int32_t size)
+{
+	int		i;
+
+	i = HeapFirstFit(heap, size);
+
+	if (i == HEAP_NO_BLOCK)
+	{
+		HeapCompact(heap);
+		i = HeapFirstFit(heap, size);
+	}
+
+	if (i == HEAP_NO_BLOCK || heap->num_blocks >= HEAP_MAX_BLOCKS - 1)
+	{
+		return HEAP_NO_BLOCK;
+	}
+
+	return HeapCarve(heap, i, size, BLOCK_HANDLE);
+}
+
+
+// Tries to put a non-relocatable block at the start of block first
+// @return	Returns the new block's id, or HEAP_NO_BLOCK if the handles there can't be moved
+static int16_t HeapNewPtrAt(Heap *heap, int first, int32_t size)
+{
+	Heap		trial;
+	HeapBlock	moving[HEAP_MAX_BLOCKS];
+	HeapBlock	the_block;
+	int32_t		run_size = 0;
+	int16_t		ptr_id;
+	int			num_moving = 0;
+	int			last;
+	int			i;
+	int			j;
+
+	// starting at a free block below would cover the same run, and was tried first
+	if (first > 0 && heap->block[first - 1].kind == BLOCK_FREE)
+	{
+		return HEAP_NO_BLOCK;
+	}
+
+	// the run of free blocks and unlocked handles from first that covers size
+	for (last = first; last < heap->num_blocks && run_size < size; last++)
+	{
+		if (heap->block[last].kind == BLOCK_PTR || heap->block[last].locked)
+		{
+			return HEAP_NO_BLOCK;
+		}
+
+		run_size += heap->block[last].size;
+	}
+
+	if (run_size < size)
+	{
+		return HEAP_NO_BLOCK;
+	}
+
+	// on a copy: the run becomes one free block, with its handles set aside
+	trial = *heap;
+
+	for (i = first; i < last; i++)
+	{
+		if (trial.block[i].kind == BLOCK_HANDLE)
+		{
+			moving[num_moving++] = trial.block[i];
+			trial.block[i].kind = BLOCK_FREE;
+			trial.block[i].id = HEAP_NO_BLOCK;
+		}
+	}
+
+	HeapMergeFree(&trial);
+
+	for (i = 0; trial.block[i].start != heap->block[first].start; i++)
+	{
+	}
+
+	ptr_id = HeapCarve(&trial, i, size, BLOCK_PTR);
+
+	// then the handles go back in the lowest free blocks they fit, biggest first
+	for (i = 0; i < num_moving; i++)
+	{
+		for (j = i + 1; j < num_moving; j++)
+		{
+			if (moving[j].size > moving[i].size)
+			{
+				the_block = moving[i];
+				moving[i] = moving[j];
+				moving[j] = the_block;
+			}
+		}
+
+		j = HeapFirstFit(&trial, moving[i].size);
+
+		if (j == HEAP_NO_BLOCK || trial.num_blocks >= HEAP_MAX_BLOCKS - 1)
+		{
+			return HEAP_NO_BLOCK;
+		}
+
+		HeapCarve(&trial, j, moving[i].size, BLOCK_HANDLE);
+		trial.block[j].id = moving[i].id;
+		trial.next_id--;
+	}
+
+	*heap = trial;
+
+	return ptr_id;
+}
+
+
+// Puts a non-relocatable block as low as unlocked handles can be moved out of its way
+// @return	Returns the new block's id, or HEAP_NO_BLOCK if there is no room
+static int16_t HeapNewPtr(Heap *heap, int32_t size)
+{
+	int16_t		id;
+	int			pass;
+	int			i;
+
+	// the lowest place that works; if none does, compact and look again
+	for (pass = 0; pass < 2; pass++)
+	{
+		for (i = 0; i < heap->num_blocks; i++)
+		{
+			id = HeapNewPtrAt(heap, i, size);
+
+			if (id != HEAP_NO_BLOCK)
+			{
+				return id;
+			}
+		}
+
+		HeapCompact(heap);
+	}
+
+	return HEAP_NO_BLOCK;
+}
+
+
+static void HeapDispose(Heap *heap, int16_t id)
+{
+	int		i;
+
+	i = HeapFind(heap, id);
+
+	if (i != HEAP_NO_BLOCK)
+	{
+		heap->block[i].kind = BLOCK_FREE;
+		heap->block[i].locked = false;
+		heap->block[i].id = HEAP_NO_BLOCK;
+		HeapMergeFree(heap);
+	}
+}
+
+
+static void HeapSetLock(Heap *heap, int16_t id, bool locked)
+{
+	int		i;
+
+	i = HeapFind(heap, id);
+
+	if (i != HEAP_NO_BLOCK)
+	{
+		heap->block[i].locked = locked;
+	}
+}
+
+
+// @return	Returns the largest free block after compaction, as MaxBlock would
+static int32_t HeapMaxBlock(const Heap *heap)
+{
+	Heap		compacted;
+	int32_t		largest = 0;
+	int			i;
+
+	compacted = *heap;
+	HeapCompact(&compacted);
+
+	for (i = 0; i < compacted.num_blocks; i++)
+	{
+		if (compacted.block[i].kind == BLOCK_FREE && compacted.block[i].size > largest)
+		{
+			largest = compacted.block[i].size;
+		}
+	}
+
+	return largest;
+}
+
+
+// One INIT other than ours: loads, leaves something resident, closes its file
+static void HeapOtherInit(Heap *heap)
+{
+	int16_t		icon;
+	int16_t		code;
+	int16_t		temporary[4];
+	int32_t		code_size;
+	uint32_t	style;
+	int			num_temporary;
+	int			i;
+
+	// LOGIC:
+	//   every draw from HeapRandom() happens whatever the heap did, so both
+	//   installs of a boot see the same INITs doing the same things
+
+	icon = HeapNewHandle(heap, HEAP_ICON_SIZE);
+	code_size = HeapRandomSize(600, 6000);
+	code = HeapNewHandle(heap, code_size);
+	HeapSetLock(heap, code, true);
+
+	num_temporary = HeapRandom() % 4;
+
+	for (i = 0; i < num_temporary; i++)
+	{
+		temporary[i] = HeapNewHandle(heap, HeapRandomSize(200, 3000));
+	}
+
+	style = HeapRandom() % 10;
+
+	if (style < 4)
+	{
+		// copies itself, or its patch, into a NewPtrSys block
+		HeapNewPtr(heap, HeapRandomSize(200, code_size));
+	}
+	else if (style < 7)
+	{
+		// detaches in place: the code stays where it was loaded, locked
+		code = HEAP_NO_BLOCK;
+	}
+	else
+	{
+		// keeps some state in a handle, locked or not
+		HeapSetLock(heap, HeapNewHandle(heap, HeapRandomSize(100, 2000)), (style == 9));
+	}
+
+	for (i = 0; i < num_temporary; i++)
+	{
+		HeapDispose(heap, temporary[i]);
+	}
+
+	// INIT 31 closes the file, which releases the resources still attached
+	HeapDispose(heap, icon);
+
+	if (code != HEAP_NO_BLOCK)
+	{
+		HeapDispose(heap, code);
+	}
+}
+
+
+// One whole boot
+static HeapBootResult HeapBoot(uint32_t seed, int install, int32_t code_size)
+{
+	Heap			heap;
+	HeapBootResult	result;
+	int16_t			system_resource[16];
+	int16_t			icon;
+	int16_t			code;
+	int				num_inits;
+	int				i;
+
+	heap_random = seed;
+	HeapInit(&heap);
+
+	// the System: its low globals block, then resources and drivers
+	HeapNewPtr(&heap, HeapRandomSize(8000, 20000));
+
+	for (i = 0; i < 16; i++)
+	{
+		system_resource[i] = HeapNewHandle(&heap, HeapRandomSize(300, 6000));
+		HeapSetLock(&heap, system_resource[i], (HeapRandom() % 4 == 0));
+	}
+
+	// some are released again before the INITs run
+	for (i = 0; i < 16; i++)
+	{
+		if (HeapRandom() % 3 == 0)
+		{
+			HeapDispose(&heap, system_resource[i]);
+		}
+	}
+
+	num_inits = HeapRandom() % 5;
+
+	for (i = 0; i < num_inits; i++)
+	{
+		HeapOtherInit(&heap);
+	}
+
+	HeapCheck(&heap, "the INITs before ours");
+	result.before = HeapMaxBlock(&heap);
+	result.copied = false;
+
+	// ours: the Resource Manager loads the icon and the code, and locks the code
+	icon = HeapNewHandle(&heap, HEAP_ICON_SIZE);
+	code = HeapNewHandle(&heap, code_size);
+	HeapSetLock(&heap, code, true);
+
+	if (install == HEAP_INSTALL_COPY)
+	{
+		result.copied = (HeapNewPtr(&heap, code_size) != HEAP_NO_BLOCK);
+	}
+
+	if (result.copied)
+	{
+		// DrawBWIcon releases the ICN# once it is drawn, and the code
+		//  resource is released with the file
+		HeapDispose(&heap, icon);
+		HeapDispose(&heap, code);
+	}
+	else
+	{
+		// detached: stays locked where it was loaded. the ICN# is locked
+		//  until the file closes
+		HeapSetLock(&heap, icon, true);
+		HeapDispose(&heap, icon);
+	}
+
+	num_inits = 1 + HeapRandom() % 4;
+
+	for (i = 0; i < num_inits; i++)
+	{
+		HeapOtherInit(&heap);
+	}
+
+	HeapCheck(&heap, "boot");
+	result.after = HeapMaxBlock(&heap);
+
+	return result;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	HeapBootResult	result[NUM_HEAP_INSTALLS];
+	double			total_before = 0;
+	double			total_after[NUM_HEAP_INSTALLS] = {0, 0};
+	int32_t			worst_after[NUM_HEAP_INSTALLS] = {HEAP_SIZE, HEAP_SIZE};
+	int32_t			code_size = HEAP_DEFAULT_CODE_SIZE;
+	int				num_boots = HEAP_DEFAULT_BOOTS;
+	int				better = 0;
+	int				same = 0;
+	int				worse = 0;
+	int				not_copied = 0;
+	int				boot;
+	int				install;
+
+	if (argc > 1)
+	{
+		num_boots = atoi(argv[1]);
+	}
+
+	if (argc > 2)
+	{
+		code_size = atoi(argv[2]);
+	}
+
+	// blocks are word aligned
+	code_size &= ~1;
+
+	if (num_boots < 1 || code_size <= 0)
+	{
+		fprintf(stderr, "usage: heap_sim [boots] code-bytes   (code-bytes is optional when built by make)\n");
+		return 2;
+	}
+
+	for (boot = 0; boot < num_boots; boot++)
+	{
+		for (install = 0; install < NUM_HEAP_INSTALLS; install++)
+		{
+			result[install] = HeapBoot(1 + boot, install, code_size);
+			total_after[install] += result[install].after;
+
+			if (result[install].after < worst_after[install])
+			{
+				worst_after[install] = result[install].after;
+			}
+		}
+
+		total_before += result[HEAP_INSTALL_COPY].before;
+
+		if (!result[HEAP_INSTALL_COPY].copied)
+		{
+			not_copied++;
+		}
+
+		if (result[HEAP_INSTALL_COPY].after > result[HEAP_INSTALL_DETACH].after)
+		{
+			better++;
+		}
+		else if (result[HEAP_INSTALL_COPY].after == result[HEAP_INSTALL_DETACH].after)
+		{
+			same++;
+		}
+		else
+		{
+			worse++;
+		}
+
+		// same boot, both times, up to our INIT
+		if (result[HEAP_INSTALL_COPY].before != result[HEAP_INSTALL_DETACH].before)
+		{
+			fprintf(stderr, "FAIL: boot %d: the two installs saw different heaps before our INIT\n", boot + 1);
+			heap_failures++;
+		}
+	}
+
+	printf("%d boots, %d byte system heap, %d byte INIT\n", num_boots, HEAP_SIZE, code_size);
+	printf("largest free block before our INIT: %8.0f bytes (mean)\n", total_before / num_boots);
+	printf("%-20s %16s %16s\n", "after boot", "mean", "worst");
+
+	for (install = 0; install < NUM_HEAP_INSTALLS; install++)
+	{
+		printf("%-20s %16.0f %16d\n", heap_install_name[install], total_after[install] / num_boots, worst_after[install]);
+	}
+
+	printf("copy vs detach: larger in %d boots, the same in %d, smaller in %d. no room to copy in %d\n",
+		better, same, worse, not_copied);
+
+	if (heap_failures > 0)
+	{
+		fprintf(stderr, "heap_sim: %d check(s) FAILED\n", heap_failures);
+		return 1;
+	}
+
+	printf("heap_sim: all checks passed\n");
+	return 0;
+}
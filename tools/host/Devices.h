@@ -0,0 +1,2 @@
+// host stand-in, see toolbox_host.h
+#include "toolbox_host.h"
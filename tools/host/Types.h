@@ -0,0 +1,2 @@
+// host stand-in, see cursors_host.h
+#include "cursors_host.h"
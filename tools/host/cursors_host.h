@@ -0,0 +1,120 @@
+/*
+ * cursors_host.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host (Linux, macOS) stand-ins for the few Toolbox types and constants the
+ *  portable parts of Custom Cursors use, so that the same .c files the INIT
+ *  is built from can be built into the host tools and tests in tools/.
+ *
+ * The Toolbox headers the sources include (<Events.h>, <Types.h>, ...) are
+ *  one-line files in this directory that include this one, or, for the
+ *  rest of the Toolbox the INIT itself uses, toolbox_host.h. Nothing here is
+ *  used by the THINK C build.
+ *
+ * Structs keep the 68k layout (2-byte alignment), so an EventRecord is 16
+ *  bytes here too. They are in host byte order; the 68k is big endian, so
+ *  anything read from or written to a Mac file goes through the swap helpers
+ *  in the tools.
+ */
+
+#ifndef CURSORS_HOST_H_
+#define CURSORS_HOST_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define pascal					// host compilers have one calling convention
+
+#ifndef NULL
+	#define NULL				((void*)0)
+#endif
+
+#define noErr					0
+#define paramErr				-50
+
+// EventRecord.what
+#define nullEvent				0
+#define mouseDown				1
+#define mouseUp					2
+#define keyDown					3
+#define keyUp					4
+#define autoKey					5
+
+// EventRecord.message, for key events
+#define charCodeMask			0x000000FF
+#define keyCodeMask				0x0000FF00
+
+// EventRecord.modifiers
+#define activeFlag				0x0001
+#define btnState				0x0080
+#define cmdKey					0x0100
+#define shiftKey				0x0200
+#define alphaLock				0x0400
+#define optionKey				0x0800
+#define controlKey				0x1000
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef unsigned char	Boolean;
+typedef int16_t			OSErr;
+typedef uint32_t		OSType;
+typedef char*			Ptr;
+typedef Ptr*			Handle;
+typedef int32_t			Size;
+typedef long			(*ProcPtr)();
+
+#pragma pack(push, 2)
+
+typedef struct Point
+{
+	int16_t		v;
+	int16_t		h;
+} Point;
+
+typedef struct EventRecord
+{
+	int16_t		what;
+	int32_t		message;
+	int32_t		when;
+	Point		where;
+	int16_t		modifiers;
+} EventRecord;
+
+#pragma pack(pop)
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+
+#endif /* CURSORS_HOST_H_ */
@@ -0,0 +1,22 @@
+#!/usr/bin/perl -0p
+#
+# strip_68k.pl
+#
+# Makes a host copy of one of the INIT's THINK C source files, by taking out
+#  the few things only THINK C understands. Line numbers are kept, so compiler
+#  messages still point at the right line of the original.
+#
+#   perl host/strip_68k.pl ../custom_cursors.c > build/src/custom_cursors.c
+#
+# The host copy is for the harness in tools/ only: every asm block is gone,
+#  so anything that depends on one (reading A0/A1, the jGNEFilter glue)
+#  has to be driven from C by the harness instead.
+
+# asm { ... } blocks: 68k register shuffling
+s#\basm\s*\{[^}]*\}#";" . ("\n" x (() = $& =~ /\n/g))#ge;
+
+# inline trap words: pascal void CursorsFlushCodeCache(void) = {0x7001, 0xA198};
+s#\)\s*=\s*\{\s*0x[0-9A-Fa-f]+(?:\s*,\s*0x[0-9A-Fa-f]+)*\s*\}\s*;#);#g;
+
+# Pascal string literals: "\pName" becomes a length byte, then the text
+s#"\\p([^"]*)"#sprintf('"\\%03o%s"', length($1), $1)#ge;
@@ -0,0 +1,706 @@
+/*
+ * toolbox_host.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * A small fake Mac for the harness in tools/: just enough of the Toolbox for
+ *  the INIT's own source to install itself and run its event path on a host.
+ *  See toolbox_host.h.
+ *
+ * Files live in memory, by name; the vRefNum is ignored. Serial output goes
+ *  to host_serial_fd if the harness opened one, otherwise nowhere. Async
+ *  PBRead and PBWrite calls wait until the harness calls HostCompleteIO(),
+ *  the way a real read or write finishes some time after the call. Gestalt
+ *  knows only the selectors installed with NewGestalt, by the INIT or the
+ *  harness.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "toolbox_host.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define HOST_NUM_TRAPS				1024	// tool traps; OS traps use the first 256
+#define HOST_MAX_FILES				4
+#define HOST_MAX_OPEN				4
+#define HOST_FIRST_FILE_REFNUM		2		// 0 would look like a failed open
+#define HOST_AIN_REFNUM				-6		// what the Serial Driver's refnums really are
+#define HOST_AOUT_REFNUM			-7
+#define HOST_MAX_PENDING_IO			8
+#define HOST_MAX_GESTALT			8
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct HostFile
+{
+	bool		exists;
+	Str255		name;
+	uint8_t*	data;
+	int32_t		size;
+	int32_t		capacity;
+} HostFile;
+
+typedef struct HostOpenFile
+{
+	HostFile*	file;			// NULL if the refnum is free
+	int32_t		mark;
+} HostOpenFile;
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static long				host_trap_table[2][HOST_NUM_TRAPS];
+static HostFile			host_files[HOST_MAX_FILES];
+static HostOpenFile		host_open_files[HOST_MAX_OPEN];
+static ParmBlkPtr		host_pending_io[HOST_MAX_PENDING_IO];
+static bool				host_pending_is_read[HOST_MAX_PENDING_IO];
+static int				host_pending_io_count;
+static OSType			host_gestalt_selector[HOST_MAX_GESTALT];
+static ProcPtr			host_gestalt_function[HOST_MAX_GESTALT];
+static int				host_gestalt_count;
+static int				host_data_probe;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+int32_t		host_tick_count = 0;
+bool		host_button_down = false;
+VBLTask*	host_vbl_task = NULL;
+int			host_serial_fd = -1;
+EvQEl		host_last_posted;
+int32_t		host_posted_count = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// @return	Returns the file with this Pascal string name, or NULL
+static HostFile* HostFindFile(const uint8_t *name);
+
+// @return	Returns the open file for a refnum, or NULL if not open
+static HostOpenFile* HostOpenFileFor(short refNum);
+
+// Writes count bytes at the mark, growing the file as needed
+static void HostFileWrite(HostOpenFile *open_file, const void *buffer, int32_t count);
+
+// Sets the mark for a PBRead or PBWrite
+static void HostSetMark(HostOpenFile *open_file, const IOParam *io);
+
+// Does the actual work of a PBRead, sync or async
+static OSErr HostDoRead(ParmBlkPtr paramBlock);
+
+// Does the actual work of a PBWrite, sync or async
+static OSErr HostDoWrite(ParmBlkPtr paramBlock);
+
+// Queues an async PBRead or PBWrite for HostCompleteIO()
+static OSErr HostQueueIO(ParmBlkPtr paramBlock, bool is_read);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// @return	Returns the file with this Pascal string name, or NULL
+static HostFile* HostFindFile(const uint8_t *name)
+{
+	int		i;
+
+	for (i = 0; i < HOST_MAX_FILES; i++)
+	{
+		if (host_files[i].exists && memcmp(host_files[i].name, name, name[0] + 1) == 0)
+		{
+			return &host_files[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+// @return	Returns the open file for a refnum, or NULL if not open
+static HostOpenFile* HostOpenFileFor(short refNum)
+{
+	int		i = refNum - HOST_FIRST_FILE_REFNUM;
+
+	if (i < 0 || i >= HOST_MAX_OPEN || host_open_files[i].file == NULL)
+	{
+		return NULL;
+	}
+
+	return &host_open_files[i];
+}
+
+
+// Writes count bytes at the mark, growing the file as needed
+static void HostFileWrite(HostOpenFile *open_file, const void *buffer, int32_t count)
+{
+	HostFile*	the_file = open_file->file;
+
+	if (open_file->mark + count > the_file->capacity)
+	{
+		the_file->capacity = (open_file->mark + count) * 2;
+		the_file->data = realloc(the_file->data, the_file->capacity);
+	}
+
+	memcpy(the_file->data + open_file->mark, buffer, count);
+	open_file->mark += count;
+
+	if (open_file->mark > the_file->size)
+	{
+		the_file->size = open_file->mark;
+	}
+}
+
+
+// Sets the mark for a PBRead or PBWrite
+static void HostSetMark(HostOpenFile *open_file, const IOParam *io)
+{
+	if (io->ioPosMode == fsFromLEOF)
+	{
+		open_file->mark = open_file->file->size + io->ioPosOffset;
+	}
+	else if (io->ioPosMode == fsFromStart)
+	{
+		open_file->mark = io->ioPosOffset;
+	}
+}
+
+
+// Does the actual work of a PBRead, sync or async
+static OSErr HostDoRead(ParmBlkPtr paramBlock)
+{
+	IOParam*		io = &paramBlock->ioParam;
+	HostOpenFile*	open_file = HostOpenFileFor(io->ioRefNum);
+	int32_t			available;
+
+	io->ioActCount = 0;
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	HostSetMark(open_file, io);
+
+	available = open_file->file->size - open_file->mark;
+	io->ioActCount = (io->ioReqCount < available) ? io->ioReqCount : available;
+
+	memcpy(io->ioBuffer, open_file->file->data + open_file->mark, io->ioActCount);
+	open_file->mark += io->ioActCount;
+
+	// as the File Manager does: a read that runs into the end returns what it got, and eofErr
+	return (io->ioActCount < io->ioReqCount) ? eofErr : noErr;
+}
+
+
+// Does the actual work of a PBWrite, sync or async
+static OSErr HostDoWrite(ParmBlkPtr paramBlock)
+{
+	IOParam*		io = &paramBlock->ioParam;
+	HostOpenFile*	open_file;
+
+	io->ioActCount = 0;
+
+	if (io->ioRefNum == HOST_AOUT_REFNUM)
+	{
+		if (host_serial_fd >= 0 && write(host_serial_fd, io->ioBuffer, io->ioReqCount) != io->ioReqCount)
+		{
+			return ioErr;
+		}
+
+		io->ioActCount = io->ioReqCount;
+		return noErr;
+	}
+
+	open_file = HostOpenFileFor(io->ioRefNum);
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	HostSetMark(open_file, io);
+	HostFileWrite(open_file, io->ioBuffer, io->ioReqCount);
+	io->ioActCount = io->ioReqCount;
+
+	return noErr;
+}
+
+
+// Queues an async PBRead or PBWrite for HostCompleteIO()
+static OSErr HostQueueIO(ParmBlkPtr paramBlock, bool is_read)
+{
+	// not queued: the call fails at once, with no completion to follow
+	if (host_pending_io_count >= HOST_MAX_PENDING_IO)
+	{
+		paramBlock->ioParam.ioResult = ioErr;
+		return ioErr;
+	}
+
+	// queued: ioResult stays positive (busy) until it finishes
+	paramBlock->ioParam.ioResult = 1;
+	host_pending_is_read[host_pending_io_count] = is_read;
+	host_pending_io[host_pending_io_count++] = paramBlock;
+
+	return noErr;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+// **** harness side *****
+
+// Checks that code and data addresses fit in 32 bits, as the INIT assumes
+// @return	Returns true if they do (the harness was linked with -no-pie)
+bool HostCheckAddresses(void)
+{
+	long	code = (long)HostCheckAddresses;
+	long	data = (long)&host_data_probe;
+
+	return (code == (long)(int32_t)code && data == (long)(int32_t)data);
+}
+
+
+// Empties the trap table (every trap unimplemented) and resets the fake Mac
+void HostResetToolbox(void)
+{
+	int		i;
+
+	memset(host_trap_table, 0, sizeof(host_trap_table));
+
+	for (i = 0; i < HOST_MAX_FILES; i++)
+	{
+		free(host_files[i].data);
+	}
+
+	memset(host_files, 0, sizeof(host_files));
+	memset(host_open_files, 0, sizeof(host_open_files));
+	host_pending_io_count = 0;
+	host_gestalt_count = 0;
+	host_tick_count = 0;
+	host_button_down = false;
+	host_vbl_task = NULL;
+	host_posted_count = 0;
+}
+
+
+// Finishes every async read or write started so far, oldest first, and runs
+//  its completion routine, as the Device Manager would at interrupt time
+// @return	Returns the number of reads and writes completed
+int HostCompleteIO(void)
+{
+	ParmBlkPtr	the_pb;
+	int			completed = 0;
+	int			started;
+
+	// a completion routine may start the next one; that one waits for next time
+	started = host_pending_io_count;
+
+	while (completed < started)
+	{
+		the_pb = host_pending_io[completed];
+		the_pb->ioParam.ioResult = host_pending_is_read[completed] ? HostDoRead(the_pb) : HostDoWrite(the_pb);
+		completed++;
+
+		if (the_pb->ioParam.ioCompletion != NULL)
+		{
+			((void (*)(void))the_pb->ioParam.ioCompletion)();
+		}
+	}
+
+	memmove(host_pending_io, host_pending_io + completed, (host_pending_io_count - completed) * sizeof(ParmBlkPtr));
+	memmove(host_pending_is_read, host_pending_is_read + completed, (host_pending_io_count - completed) * sizeof(bool));
+	host_pending_io_count -= completed;
+
+	return completed;
+}
+
+
+// @return	Returns the contents of an in-memory file, or NULL if there is none
+const uint8_t* HostFileContents(const uint8_t *name, int32_t *size)
+{
+	HostFile*	the_file = HostFindFile(name);
+
+	if (the_file == NULL)
+	{
+		*size = 0;
+		return NULL;
+	}
+
+	*size = the_file->size;
+	return the_file->data;
+}
+
+
+
+// **** traps *****
+
+long NGetTrapAddress(int trapNum, int tType)
+{
+	return host_trap_table[tType == ToolTrap][trapNum & (tType == ToolTrap ? 0x3FF : 0xFF)];
+}
+
+
+void NSetTrapAddress(long trapAddr, int trapNum, int tType)
+{
+	host_trap_table[tType == ToolTrap][trapNum & (tType == ToolTrap ? 0x3FF : 0xFF)] = trapAddr;
+}
+
+
+Boolean CallPascalB(short eventMask, EventRecord *theEvent, long procAddr)
+{
+	return ((Boolean (*)(short, EventRecord*))procAddr)(eventMask, theEvent);
+}
+
+
+
+// **** OS Utilities, Memory Manager *****
+
+Boolean Button(void)
+{
+	return host_button_down;
+}
+
+
+int32_t TickCount(void)
+{
+	return host_tick_count;
+}
+
+
+OSErr SysEnvirons(short versionRequested, SysEnvRec *theWorld)
+{
+	memset(theWorld, 0, sizeof(SysEnvRec));
+	theWorld->environsVersion = versionRequested;
+	theWorld->systemVersion = 0x0608;
+	theWorld->sysVRefNum = -1;
+
+	return noErr;
+}
+
+
+Handle RecoverHandle(Ptr p)
+{
+	return NULL;
+}
+
+
+Size GetHandleSize(Handle h)
+{
+	return 0;
+}
+
+
+void DetachResource(Handle theResource)
+{
+}
+
+
+Ptr NewPtrSys(Size byteCount)
+{
+	return calloc(1, byteCount);
+}
+
+
+void DisposePtr(Ptr p)
+{
+	free(p);
+}
+
+
+void BlockMove(const void *srcPtr, void *destPtr, Size byteCount)
+{
+	memmove(destPtr, srcPtr, byteCount);
+}
+
+
+void CursorsFlushCodeCache(void)
+{
+}
+
+
+pascal void ShowInitIcon(short iconFamilyID, Boolean advance)
+{
+}
+
+
+
+// **** Gestalt, VBL, Event Manager *****
+
+OSErr Gestalt(OSType selector, long *response)
+{
+	int		i;
+
+	for (i = 0; i < host_gestalt_count; i++)
+	{
+		if (host_gestalt_selector[i] == selector)
+		{
+			return ((OSErr (*)(OSType, long*))host_gestalt_function[i])(selector, response);
+		}
+	}
+
+	return gestaltUndefSelectorErr;
+}
+
+
+OSErr NewGestalt(OSType selector, ProcPtr gestaltFunction)
+{
+	int		i;
+
+	for (i = 0; i < host_gestalt_count; i++)
+	{
+		if (host_gestalt_selector[i] == selector)
+		{
+			return gestaltDupSelectorErr;
+		}
+	}
+
+	if (host_gestalt_count >= HOST_MAX_GESTALT)
+	{
+		return memFullErr;
+	}
+
+	host_gestalt_selector[host_gestalt_count] = selector;
+	host_gestalt_function[host_gestalt_count++] = gestaltFunction;
+
+	return noErr;
+}
+
+
+OSErr VInstall(QElemPtr vblTaskPtr)
+{
+	host_vbl_task = (VBLTask*)vblTaskPtr;
+	return noErr;
+}
+
+
+OSErr VRemove(QElemPtr vblTaskPtr)
+{
+	host_vbl_task = NULL;
+	return noErr;
+}
+
+
+OSErr PPostEvent(short eventCode, long eventMsg, EvQElPtr *qEl)
+{
+	// the "queue" holds one event. the INIT sets the modifiers through qEl
+	//  after the call, so the harness sees them in host_last_posted
+	memset(&host_last_posted, 0, sizeof(EvQEl));
+	host_last_posted.evtQWhat = eventCode;
+	host_last_posted.evtQMessage = eventMsg;
+	host_last_posted.evtQWhen = host_tick_count;
+	*qEl = &host_last_posted;
+	host_posted_count++;
+
+	return noErr;
+}
+
+
+
+// **** File Manager *****
+
+OSErr Create(StringPtr fileName, short vRefNum, OSType creator, OSType fileType)
+{
+	int		i;
+
+	if (HostFindFile(fileName) != NULL)
+	{
+		return dupFNErr;
+	}
+
+	for (i = 0; i < HOST_MAX_FILES; i++)
+	{
+		if (!host_files[i].exists)
+		{
+			host_files[i].exists = true;
+			memcpy(host_files[i].name, fileName, fileName[0] + 1);
+			return noErr;
+		}
+	}
+
+	return ioErr;
+}
+
+
+OSErr FSOpen(StringPtr fileName, short vRefNum, short *refNum)
+{
+	HostFile*	the_file = HostFindFile(fileName);
+	int			i;
+
+	if (the_file == NULL)
+	{
+		return fnfErr;
+	}
+
+	for (i = 0; i < HOST_MAX_OPEN; i++)
+	{
+		if (host_open_files[i].file == NULL)
+		{
+			host_open_files[i].file = the_file;
+			host_open_files[i].mark = 0;
+			*refNum = HOST_FIRST_FILE_REFNUM + i;
+			return noErr;
+		}
+	}
+
+	return ioErr;
+}
+
+
+OSErr FSClose(short refNum)
+{
+	HostOpenFile*	open_file = HostOpenFileFor(refNum);
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	open_file->file = NULL;
+	return noErr;
+}
+
+
+OSErr FSRead(short refNum, int32_t *count, Ptr buffPtr)
+{
+	HostOpenFile*	open_file = HostOpenFileFor(refNum);
+	int32_t			available;
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	available = open_file->file->size - open_file->mark;
+
+	if (*count > available)
+	{
+		*count = available;
+	}
+
+	memcpy(buffPtr, open_file->file->data + open_file->mark, *count);
+	open_file->mark += *count;
+
+	return (*count == 0) ? eofErr : noErr;
+}
+
+
+OSErr FSWrite(short refNum, int32_t *count, Ptr buffPtr)
+{
+	HostOpenFile*	open_file = HostOpenFileFor(refNum);
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	HostFileWrite(open_file, buffPtr, *count);
+	return noErr;
+}
+
+
+OSErr SetFPos(short refNum, short posMode, long posOff)
+{
+	HostOpenFile*	open_file = HostOpenFileFor(refNum);
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	open_file->mark = (posMode == fsFromLEOF) ? open_file->file->size + posOff : posOff;
+	return noErr;
+}
+
+
+OSErr SetEOF(short refNum, long logEOF)
+{
+	HostOpenFile*	open_file = HostOpenFileFor(refNum);
+
+	if (open_file == NULL)
+	{
+		return paramErr;
+	}
+
+	open_file->file->size = logEOF;
+
+	if (open_file->mark > logEOF)
+	{
+		open_file->mark = logEOF;
+	}
+
+	return noErr;
+}
+
+
+
+// **** Device Manager, Serial Driver *****
+
+OSErr OpenDriver(StringPtr name, short *drvrRefNum)
+{
+	*drvrRefNum = (memcmp(name, "\004.AIn", 5) == 0) ? HOST_AIN_REFNUM : HOST_AOUT_REFNUM;
+	return noErr;
+}
+
+
+OSErr SerReset(short refNum, short serConfig)
+{
+	return noErr;
+}
+
+
+OSErr PBRead(ParmBlkPtr paramBlock, Boolean async)
+{
+	if (!async)
+	{
+		paramBlock->ioParam.ioResult = HostDoRead(paramBlock);
+		return paramBlock->ioParam.ioResult;
+	}
+
+	return HostQueueIO(paramBlock, true);
+}
+
+
+OSErr PBWrite(ParmBlkPtr paramBlock, Boolean async)
+{
+	if (!async)
+	{
+		paramBlock->ioParam.ioResult = HostDoWrite(paramBlock);
+		return paramBlock->ioParam.ioResult;
+	}
+
+	return HostQueueIO(paramBlock, false);
+}
@@ -0,0 +1,232 @@
+/*
+ * toolbox_host.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host stand-ins for the rest of the Toolbox: the traps, Memory Manager,
+ *  File Manager, Device Manager and VBL calls that the INIT itself
+ *  (custom_cursors.c) and its optional modules make. Lets the harness in
+ *  tools/ build the INIT's own source and drive it from C.
+ *
+ * The calls are implemented in toolbox_host.c, as a small fake Mac: a trap
+ *  table, a tick count, a Button() the harness sets. Low memory globals are
+ *  not faked; a harness must keep the INIT off code paths that touch them.
+ *
+ * THINK C keeps trap addresses in 32-bit variables, and so does the INIT, so
+ *  anything that ends up in the trap table must have a 32-bit address. Link
+ *  harness programs with -no-pie; HostCheckAddresses() makes sure it worked.
+ */
+
+#ifndef TOOLBOX_HOST_H_
+#define TOOLBOX_HOST_H_
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_host.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+// THINK C's A4 globals: the host has ordinary globals
+#define RememberA0()
+#define RememberA4()
+#define SetUpA4()
+#define RestoreA4()
+
+#define OSTrap					0
+#define ToolTrap				1
+
+#define vType					1
+#define curSysEnvVers			2
+
+#define fsAtMark				0
+#define fsFromStart				1
+#define fsFromLEOF				2
+#define fsFromMark				3
+
+#define qErr					-1
+#define ioErr					-36
+#define eofErr					-39
+#define fnfErr					-43
+#define dupFNErr				-48
+#define memFullErr				-108
+#define gestaltUndefSelectorErr	-5551
+#define gestaltDupSelectorErr	-5552
+
+// SerReset config bits
+#define baud57600				0
+#define stop10					0x4000
+#define noParity				0
+#define data8					0x0C00
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef unsigned char	Str255[256];
+typedef unsigned char*	StringPtr;
+
+typedef struct QElem
+{
+	struct QElem*	qLink;
+	int16_t			qType;
+	int16_t			qData[1];
+} QElem, *QElemPtr;
+
+typedef struct VBLTask
+{
+	QElemPtr		qLink;
+	int16_t			qType;
+	ProcPtr			vblAddr;
+	int16_t			vblCount;
+	int16_t			vblPhase;
+} VBLTask;
+
+typedef struct SysEnvRec
+{
+	int16_t			environsVersion;
+	int16_t			machineType;
+	int16_t			systemVersion;
+	int16_t			processor;
+	Boolean			hasFPU;
+	Boolean			hasColorQD;
+	int16_t			keyBoardType;
+	int16_t			atDrvrVersNum;
+	int16_t			sysVRefNum;
+} SysEnvRec;
+
+typedef struct EvQEl
+{
+	QElemPtr		qLink;
+	int16_t			qType;
+	int16_t			evtQWhat;
+	int32_t			evtQMessage;
+	int32_t			evtQWhen;
+	Point			evtQWhere;
+	int16_t			evtQModifiers;
+} EvQEl, *EvQElPtr;
+
+// just the fields of the real IOParam that the INIT uses
+typedef struct IOParam
+{
+	QElemPtr		qLink;
+	int16_t			qType;
+	int16_t			ioTrap;
+	Ptr				ioCmdAddr;
+	ProcPtr			ioCompletion;
+	OSErr			ioResult;
+	StringPtr		ioNamePtr;
+	int16_t			ioVRefNum;
+	int16_t			ioRefNum;
+	Ptr				ioBuffer;
+	int32_t			ioReqCount;
+	int32_t			ioActCount;
+	int16_t			ioPosMode;
+	int32_t			ioPosOffset;
+} IOParam;
+
+typedef union ParamBlockRec
+{
+	IOParam			ioParam;
+} ParamBlockRec, *ParmBlkPtr;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// the fake Mac's state, for the harness to set and check
+extern int32_t		host_tick_count;		// what TickCount() returns
+extern bool			host_button_down;		// what Button() returns
+extern VBLTask*		host_vbl_task;			// last task passed to VInstall(), or NULL
+extern int			host_serial_fd;			// where .AOut writes go, or -1 to drop them
+extern EvQEl		host_last_posted;		// last event posted with PPostEvent()
+extern int32_t		host_posted_count;
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// harness side
+
+// Checks that code and data addresses fit in 32 bits, as the INIT assumes
+// @return	Returns true if they do (the harness was linked with -no-pie)
+bool HostCheckAddresses(void);
+
+// Empties the trap table (every trap unimplemented) and resets the fake Mac
+void HostResetToolbox(void);
+
+// Finishes every async read or write started so far, oldest first, and runs
+//  its completion routine, as the Device Manager would at interrupt time
+// @return	Returns the number of reads and writes completed
+int HostCompleteIO(void);
+
+// @return	Returns the contents of an in-memory file, or NULL if there is none
+const uint8_t* HostFileContents(const uint8_t *name, int32_t *size);
+
+// The INIT's inline _HWPriv call; strip_68k.pl leaves only its prototype
+pascal void CursorsFlushCodeCache(void);
+
+// Toolbox side, as declared by the real headers
+
+long NGetTrapAddress(int trapNum, int tType);
+void NSetTrapAddress(long trapAddr, int trapNum, int tType);
+Boolean CallPascalB(short eventMask, EventRecord *theEvent, long procAddr);
+
+Boolean Button(void);
+int32_t TickCount(void);
+OSErr SysEnvirons(short versionRequested, SysEnvRec *theWorld);
+
+Handle RecoverHandle(Ptr p);
+Size GetHandleSize(Handle h);
+void DetachResource(Handle theResource);
+Ptr NewPtrSys(Size byteCount);
+void DisposePtr(Ptr p);
+void BlockMove(const void *srcPtr, void *destPtr, Size byteCount);
+
+OSErr Gestalt(OSType selector, long *response);
+OSErr NewGestalt(OSType selector, ProcPtr gestaltFunction);
+
+OSErr VInstall(QElemPtr vblTaskPtr);
+OSErr VRemove(QElemPtr vblTaskPtr);
+
+OSErr PPostEvent(short eventCode, long eventMsg, EvQElPtr *qEl);
+
+OSErr Create(StringPtr fileName, short vRefNum, OSType creator, OSType fileType);
+OSErr FSOpen(StringPtr fileName, short vRefNum, short *refNum);
+OSErr FSClose(short refNum);
+OSErr FSRead(short refNum, int32_t *count, Ptr buffPtr);
+OSErr FSWrite(short refNum, int32_t *count, Ptr buffPtr);
+OSErr SetFPos(short refNum, short posMode, long posOff);
+OSErr SetEOF(short refNum, long logEOF);
+
+OSErr OpenDriver(StringPtr name, short *drvrRefNum);
+OSErr SerReset(short refNum, short serConfig);
+OSErr PBRead(ParmBlkPtr paramBlock, Boolean async);
+OSErr PBWrite(ParmBlkPtr paramBlock, Boolean async);
+
+pascal void ShowInitIcon(short iconFamilyID, Boolean advance);
+
+
+#endif /* TOOLBOX_HOST_H_ */
@@ -0,0 +1,216 @@
+/*
+ * hotkey_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of the on/off hot-key inside the INIT itself: builds
+ *  custom_cursors.c against the fake Mac in host/toolbox_host.c, installs it
+ *  as a GetNextEvent patch, and types the hot-key at it.
+ *
+ * Another INIT's handler joins our dispatcher first, so turning off only
+ *  bypasses: the INIT never unhooks, and the harness stays clear of KeyMap
+ *  and the other low memory globals the unhooking path reads. In that mode
+ *  the handler must spot the hot-key that turns it back on, and no press of
+ *  the hot-key may reach the app or the other INIT.
+ *
+ * The VBL task that turns an unhooked INIT back on reads KeyMap, so it is not
+ *  run. The harness sets what it leaves behind instead (the swallow flag and
+ *  the tick it saw the key), and checks that the handler eats the keyDown of
+ *  that press, but not the next press if the app got the first one already.
+ *
+ * Usage: hotkey_sim
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// the INIT itself. its main() is the code resource entry point, not ours
+#define main	CursorsMain
+#include "custom_cursors.c"
+#undef main
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIM_EVERY_EVENT				-1
+#define SIM_HOT_KEY					0x08	// C, with command and option: the default
+#define SIM_HOT_MODIFIERS			(cmdKey | optionKey)
+#define SIM_VBL_TICK				500		// when the "VBL" saw the hot-key go down
+
+#define SIM_CHECK(condition, what)	SimCheck((condition), (what), __LINE__)
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static EventRecord		sim_next_event;		// what the "ROM" GetNextEvent hands out
+static long				sim_trap_addr;		// the patched GetNextEvent
+static int32_t			sim_later_calls = 0;	// key events the other INIT's handler got
+static int				sim_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent);
+
+// Another INIT's key handler, registered after ours
+static pascal void SimLaterHandler(EventRecord *theEvent);
+
+// One key event through the patched GetNextEvent
+// @return	Returns true if the app gets it; the event it gets is in *theEvent
+static bool SimType(int16_t what, uint8_t key, int16_t modifiers, int32_t when, EventRecord *theEvent);
+
+// @return	Returns true if a mapped key comes out remapped
+static bool SimRemaps(int32_t when);
+
+// @return	Returns true if the hot-key's keyDown is eaten
+static bool SimHotKeyEaten(int16_t what, int32_t when);
+
+static void SimCheck(bool condition, const char *what, int line);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent)
+{
+	*theEvent = sim_next_event;
+	return (theEvent->what != nullEvent);
+}
+
+
+// Another INIT's key handler, registered after ours
+static pascal void SimLaterHandler(EventRecord *theEvent)
+{
+	sim_later_calls++;
+}
+
+
+// One key event through the patched GetNextEvent
+// @return	Returns true if the app gets it; the event it gets is in *theEvent
+static bool SimType(int16_t what, uint8_t key, int16_t modifiers, int32_t when, EventRecord *theEvent)
+{
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	sim_next_event.what = what;
+	sim_next_event.message = (key << 8) | 'c';
+	sim_next_event.when = when;
+	sim_next_event.modifiers = modifiers;
+
+	return CallPascalB(SIM_EVERY_EVENT, theEvent, sim_trap_addr) && theEvent->what != nullEvent;
+}
+
+
+// @return	Returns true if a mapped key comes out remapped
+static bool SimRemaps(int32_t when)
+{
+	EventRecord		the_event;
+
+	return SimType(keyDown, cursors_key[0], alphaLock, when, &the_event) && (the_event.message & 0xFFFF) == cursors_remap[0];
+}
+
+
+// @return	Returns true if the hot-key's keyDown is eaten
+static bool SimHotKeyEaten(int16_t what, int32_t when)
+{
+	EventRecord		the_event;
+	int32_t			later_calls = sim_later_calls;
+
+	return !SimType(what, SIM_HOT_KEY, SIM_HOT_MODIFIERS, when, &the_event) && sim_later_calls == later_calls;
+}
+
+
+static void SimCheck(bool condition, const char *what, int line)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAIL (line %d): %s\n", line, what);
+		sim_failures++;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(void)
+{
+	if (!HostCheckAddresses())
+	{
+		fprintf(stderr, "hotkey_sim: addresses don't fit in 32 bits; link with -no-pie\n");
+		return 1;
+	}
+
+	HostResetToolbox();
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)Gestalt, (int)GestaltTrap, OSTrap);
+
+	CursorsInstall();
+	sim_trap_addr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+
+	if (sim_trap_addr != (long)NewGetNextEvent || !CursorsDispatchRegister(&cursors_dispatcher, SimLaterHandler))
+	{
+		fprintf(stderr, "hotkey_sim: CursorsInstall() did not patch GetNextEvent\n");
+		return 1;
+	}
+
+	SIM_CHECK(SimRemaps(10), "remapping on at boot");
+
+	// off: the dispatcher is shared, so we only bypass, and no VBL is needed
+	SIM_CHECK(SimHotKeyEaten(keyDown, 20) && !cursors_enabled, "hot-key turns remapping off, and is eaten");
+	SIM_CHECK(!cursors_unhooked && host_vbl_task == NULL, "bypassing, with no VBL task");
+	SIM_CHECK(SimHotKeyEaten(autoKey, 21), "hot-key repeat eaten while off");
+	SIM_CHECK(!SimRemaps(30), "keys pass through while off");
+
+	// on again: the handler sees the hot-key itself
+	SIM_CHECK(SimHotKeyEaten(keyDown, 40) && cursors_enabled, "hot-key turns remapping back on, and is eaten");
+	SIM_CHECK(SimHotKeyEaten(autoKey, 41) && cursors_enabled, "hot-key repeat eaten, remapping stays on");
+	SIM_CHECK(SimRemaps(50), "remapping on again");
+
+	// what the VBL leaves behind when it turns an unhooked INIT back on
+	cursors_toggle_seen_tick = SIM_VBL_TICK;
+	cursors_swallow_toggle = true;
+	SIM_CHECK(SimHotKeyEaten(keyDown, SIM_VBL_TICK) && cursors_enabled, "keyDown of the press the VBL saw is eaten, remapping stays on");
+	SIM_CHECK(SimHotKeyEaten(keyDown, SIM_VBL_TICK + 30) && !cursors_enabled, "the next press turns remapping off");
+	SIM_CHECK(SimHotKeyEaten(keyDown, SIM_VBL_TICK + 60) && cursors_enabled, "and on again");
+
+	// the app got the keyDown before the VBL rehooked us: the flag must not eat the next press
+	cursors_toggle_seen_tick = 2 * SIM_VBL_TICK;
+	cursors_swallow_toggle = true;
+	SIM_CHECK(SimHotKeyEaten(autoKey, 2 * SIM_VBL_TICK + 20) && cursors_enabled, "a repeat doesn't turn remapping off");
+	cursors_swallow_toggle = true;
+	SIM_CHECK(SimHotKeyEaten(keyDown, 2 * SIM_VBL_TICK + 40) && !cursors_enabled, "a later press isn't taken for the one the VBL saw");
+
+	if (sim_failures > 0)
+	{
+		fprintf(stderr, "hotkey_sim: %d check(s) FAILED\n", sim_failures);
+		return 1;
+	}
+
+	printf("hotkey_sim: all checks passed\n");
+	return 0;
+}
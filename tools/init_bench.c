@@ -0,0 +1,232 @@
+/*
+ * init_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host benchmark of the INIT's own event path. Builds one INIT variant
+ *  straight from its source (CURSORS_INIT_SRC, default custom_cursors.c, as
+ *  stripped by host/strip_68k.pl), installs it into the fake Mac in
+ *  host/toolbox_host.c as a GetNextEvent trap patch, then pulls events
+ *  through the patched trap and through the bare one, and prints the
+ *  difference per event. Every event that comes out is checked too.
+ *
+ * These are host nanoseconds, not 68000 cycles: good for comparing variants
+ *  and changes with each other on one machine, nothing more.
+ *
+ * Usage: init_bench [events]     (default 100000 of each kind)
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// the INIT itself. its main() is the code resource entry point, not ours
+#ifndef CURSORS_INIT_SRC
+	#define CURSORS_INIT_SRC	"custom_cursors.c"
+#endif
+
+#define main	CursorsMain
+#include CURSORS_INIT_SRC
+#undef main
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define BENCH_EVERY_EVENT			-1
+#define BENCH_DEFAULT_EVENTS		100000
+#define BENCH_RUNS					21		// best of: the host is not a quiet 68000
+
+#define BENCH_KIND_REMAPPED			0		// a mapped key, with the modifier down
+#define BENCH_KIND_OTHER_KEY		1		// an unmapped key
+#define BENCH_KIND_NULL				2		// no event
+#define NUM_BENCH_KINDS				3
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static EventRecord		bench_next_event;	// what the "ROM" GetNextEvent hands out
+static uint32_t			bench_failures = 0;
+
+static const char*		bench_kind_name[NUM_BENCH_KINDS] =
+{
+	"remapped key",
+	"other key",
+	"null event",
+};
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean BenchROMGetNextEvent(short eventMask, EventRecord *theEvent);
+
+// Sets up the event the ROM will hand out for one kind of benchmark
+// @return	Returns the message the app should see once the INIT is in
+static int32_t BenchScriptEvent(int kind);
+
+// Pulls num_events through one GetNextEvent, checking each one
+// @return	Returns the fastest run, in ns per event
+static double BenchRun(int kind, long num_events, long trap_addr, int32_t expected);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean BenchROMGetNextEvent(short eventMask, EventRecord *theEvent)
+{
+	*theEvent = bench_next_event;
+	return (theEvent->what != nullEvent);
+}
+
+
+// Sets up the event the ROM will hand out for one kind of benchmark
+// @return	Returns the message the app should see once the INIT is in
+static int32_t BenchScriptEvent(int kind)
+{
+	const CursorsKeymap*	map = cursors_keymap_tables.active;
+
+	memset(&bench_next_event, 0, sizeof(EventRecord));
+
+	switch (kind)
+	{
+		case BENCH_KIND_REMAPPED:
+			bench_next_event.what = keyDown;
+			bench_next_event.message = (map->key[2] << 8) | 'x';
+			bench_next_event.modifiers = (map->modifier_choice == MODIFIER_OPT_KEY) ? optionKey : alphaLock;
+			return (bench_next_event.message & 0xFFFF0000) | map->remap[2];
+
+		case BENCH_KIND_OTHER_KEY:
+			bench_next_event.what = keyDown;
+			bench_next_event.message = (0x2F << 8) | '.';	// period: mapped by no layout
+			return bench_next_event.message;
+
+		default:
+			bench_next_event.what = nullEvent;
+			return 0;
+	}
+}
+
+
+// Pulls num_events through one GetNextEvent, checking each one
+// @return	Returns the fastest run, in ns per event
+static double BenchRun(int kind, long num_events, long trap_addr, int32_t expected)
+{
+	EventRecord			the_event;
+	struct timespec		start;
+	struct timespec		end;
+	long				n;
+	int					run;
+	double				ns;
+	double				best = 0;
+	Boolean				event_needs_action;
+
+	for (run = 0; run < BENCH_RUNS; run++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for (n = 0; n < num_events; n++)
+		{
+			event_needs_action = CallPascalB(BENCH_EVERY_EVENT, &the_event, trap_addr);
+
+			if (event_needs_action != (kind != BENCH_KIND_NULL) || (event_needs_action && the_event.message != expected))
+			{
+				bench_failures++;
+			}
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / num_events;
+
+		if (run == 0 || ns < best)
+		{
+			best = ns;
+		}
+	}
+
+	return best;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	double		bare_ns;
+	double		patched_ns;
+	long		num_events = BENCH_DEFAULT_EVENTS;
+	long		patched_addr;
+	int32_t		expected;
+	int			kind;
+
+	if (argc > 1)
+	{
+		num_events = atol(argv[1]);
+	}
+
+	if (!HostCheckAddresses())
+	{
+		fprintf(stderr, "init_bench: addresses don't fit in 32 bits; link with -no-pie\n");
+		return 1;
+	}
+
+	HostResetToolbox();
+	NSetTrapAddress((long)BenchROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+
+	CursorsInstall();
+	patched_addr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+
+	if (patched_addr != (long)NewGetNextEvent)
+	{
+		fprintf(stderr, "init_bench: CursorsInstall() did not patch GetNextEvent\n");
+		return 1;
+	}
+
+	printf("%s\n%-14s %10s %10s %10s   (host ns/event)\n", CURSORS_INIT_SRC, "", "bare", "patched", "overhead");
+
+	for (kind = 0; kind < NUM_BENCH_KINDS; kind++)
+	{
+		expected = BenchScriptEvent(kind);
+
+		// same event through the original trap (as if no INIT), then through ours
+		bare_ns = BenchRun(kind, num_events, (long)BenchROMGetNextEvent, bench_next_event.message);
+		patched_ns = BenchRun(kind, num_events, patched_addr, expected);
+
+		printf("%-14s %10.2f %10.2f %10.2f\n", bench_kind_name[kind], bare_ns, patched_ns, patched_ns - bare_ns);
+	}
+
+	if (bench_failures > 0)
+	{
+		fprintf(stderr, "init_bench: %u event(s) came out wrong\n", bench_failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,435 @@
+/*
+ * journal_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of the keystroke journal (cursors_journal.c) inside the
+ *  INIT itself: builds custom_cursors.c against the fake Mac in
+ *  host/toolbox_host.c, installs it as a GetNextEvent patch, and types into
+ *  it while recording.
+ *
+ * The fake Mac's PBWrite only queues asynchronous writes; they finish when
+ *  the harness calls HostCompleteIO(), the way the disk would finish them
+ *  later. So the simulation can check that GetNextEvent only ever starts a
+ *  write and never waits for one, that typing carries on while a write is in
+ *  flight, that a wrapped ring goes out in order, that stopping mid-write
+ *  finishes the file, and that the file holds exactly the key events the
+ *  application got, also when another INIT's handler, registered after ours
+ *  in our dispatcher, changes or swallows them. Playback reads the file
+ *  with async reads too, so it only posts events once the harness has
+ *  finished the read.
+ *
+ * Last, the INIT is installed again, this time joining another INIT's
+ *  dispatcher, where it gets no idle time. The key path must write the ring
+ *  out as it fills, so a long recording loses nothing, and playback must be
+ *  refused.
+ *
+ * Usage: journal_sim
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// the INIT itself. its main() is the code resource entry point, not ours
+#define main	CursorsMain
+#include "custom_cursors.c"
+#undef main
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIM_EVERY_EVENT				-1
+#define SIM_MAX_DELIVERED			512
+#define SIM_PAUSE_TICKS				100		// more than the journal's flush pause
+#define SIM_LATER_CHANGES_KEY		0x2F	// the later INIT's handler changes this key's char
+#define SIM_LATER_SWALLOWS_KEY		0x12	// and swallows this one
+#define SIM_JOINED_KEYS				300		// more than the ring holds
+#define SIM_RING_SIZE				128		// cursors_journal.c's JOURNAL_RING_SIZE
+#define SIM_MAX_IDLES				1000
+
+#define SIM_CHECK(condition, what)	SimCheck((condition), (what), __LINE__)
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// "\pCustom Cursors Journal", as the host compiler can't write \p
+static uint8_t			sim_journal_name[] = "\026Custom Cursors Journal";
+
+static EventRecord		sim_next_event;		// what the "ROM" GetNextEvent hands out
+static long				sim_trap_addr;		// the patched GetNextEvent
+
+static CursorsDispatcher	sim_other_dispatcher;	// the other INIT's, in the joined run
+
+static EventRecord		sim_delivered[SIM_MAX_DELIVERED];	// key events the app got while recording
+static int				sim_delivered_count = 0;
+static int				sim_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent);
+
+// Another INIT's key handler, registered after ours
+static pascal void SimLaterHandler(EventRecord *theEvent);
+
+// One key event through the patched GetNextEvent, kept if the app gets it
+static void SimType(uint8_t key, bool with_option);
+
+// One null event through the patched GetNextEvent: idle time for the INIT
+static void SimIdle(void);
+
+// The other INIT's Gestalt function, in the joined run
+static pascal OSErr SimOtherGestalt(OSType selector, long *response);
+
+// One key event through the other INIT's GetNextEvent patch, in the joined run
+static void SimTypeJoined(uint8_t key, bool with_option);
+
+// Plays the journal file back, finishing each read as it is started
+// @return	Returns the number of events posted
+static int32_t SimPlayBack(void);
+
+// @return	Returns the number of records in the journal file
+static int32_t SimFileRecords(void);
+
+// Checks that the journal file holds exactly the key events delivered
+static void SimCheckFile(const char *what, int line);
+
+static void SimCheck(bool condition, const char *what, int line);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent)
+{
+	*theEvent = sim_next_event;
+	return (theEvent->what != nullEvent);
+}
+
+
+// Another INIT's key handler, registered after ours
+static pascal void SimLaterHandler(EventRecord *theEvent)
+{
+	switch ((theEvent->message & keyCodeMask) >> 8)
+	{
+		case SIM_LATER_CHANGES_KEY:
+			theEvent->message = (theEvent->message & ~charCodeMask) | '!';
+			break;
+
+		case SIM_LATER_SWALLOWS_KEY:
+			theEvent->what = nullEvent;
+			break;
+	}
+}
+
+
+// One key event through the patched GetNextEvent, kept if the app gets it
+static void SimType(uint8_t key, bool with_option)
+{
+	EventRecord		the_event;
+
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	sim_next_event.what = keyDown;
+	sim_next_event.message = (key << 8) | (0x20 + (sim_delivered_count & 0x3F));
+	sim_next_event.when = host_tick_count;
+	sim_next_event.modifiers = with_option ? optionKey : 0;
+
+	if (CallPascalB(SIM_EVERY_EVENT, &the_event, sim_trap_addr) && sim_delivered_count < SIM_MAX_DELIVERED)
+	{
+		sim_delivered[sim_delivered_count++] = the_event;
+	}
+
+	host_tick_count++;
+}
+
+
+// One null event through the patched GetNextEvent: idle time for the INIT
+static void SimIdle(void)
+{
+	EventRecord		the_event;
+
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	CallPascalB(SIM_EVERY_EVENT, &the_event, sim_trap_addr);
+}
+
+
+// The other INIT's Gestalt function, in the joined run
+static pascal OSErr SimOtherGestalt(OSType selector, long *response)
+{
+	*response = (long)&sim_other_dispatcher;
+	return noErr;
+}
+
+
+// One key event through the other INIT's GetNextEvent patch, in the joined run
+static void SimTypeJoined(uint8_t key, bool with_option)
+{
+	EventRecord		the_event;
+
+	memset(&the_event, 0, sizeof(EventRecord));
+	the_event.what = keyDown;
+	the_event.message = (key << 8) | (0x20 + (sim_delivered_count & 0x3F));
+	the_event.when = host_tick_count;
+	the_event.modifiers = with_option ? optionKey : 0;
+
+	if (!CursorsDispatchKey(&sim_other_dispatcher, &the_event) && sim_delivered_count < SIM_MAX_DELIVERED)
+	{
+		sim_delivered[sim_delivered_count++] = the_event;
+	}
+
+	host_tick_count++;
+}
+
+
+// Plays the journal file back, finishing each read as it is started
+// @return	Returns the number of events posted
+static int32_t SimPlayBack(void)
+{
+	int32_t		posted_before = host_posted_count;
+	int			i;
+
+	for (i = 0; i < SIM_MAX_IDLES && cursors_journal_state == JOURNAL_PLAYING; i++)
+	{
+		SimIdle();
+		HostCompleteIO();
+	}
+
+	return host_posted_count - posted_before;
+}
+
+
+// @return	Returns the number of records in the journal file
+static int32_t SimFileRecords(void)
+{
+	int32_t		size;
+
+	HostFileContents(sim_journal_name, &size);
+
+	return size / (int32_t)sizeof(EventRecord);
+}
+
+
+// Checks that the journal file holds exactly the key events delivered
+static void SimCheckFile(const char *what, int line)
+{
+	const uint8_t*	contents;
+	int32_t			size;
+
+	contents = HostFileContents(sim_journal_name, &size);
+
+	SimCheck(contents != NULL && size == sim_delivered_count * (int32_t)sizeof(EventRecord)
+		&& memcmp(contents, sim_delivered, size) == 0, what, line);
+}
+
+
+static void SimCheck(bool condition, const char *what, int line)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAIL (line %d): %s\n", line, what);
+		sim_failures++;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(void)
+{
+	int		i;
+
+	if (!HostCheckAddresses())
+	{
+		fprintf(stderr, "journal_sim: addresses don't fit in 32 bits; link with -no-pie\n");
+		return 1;
+	}
+
+	// a System with Gestalt, so the journal is installed
+	HostResetToolbox();
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)Gestalt, (int)GestaltTrap, OSTrap);
+
+	CursorsInstall();
+	sim_trap_addr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+
+	if (sim_trap_addr != (long)NewGetNextEvent || cursors_journal_interface.version != CURSORS_JOURNAL_VERSION)
+	{
+		fprintf(stderr, "journal_sim: CursorsInstall() did not patch GetNextEvent and set up the journal\n");
+		return 1;
+	}
+
+	SIM_CHECK(CursorsStartRecording() == noErr, "start recording");
+
+	// typing, with a short break: nothing goes to the disk yet
+	for (i = 0; i < 10; i++)
+	{
+		SimType(0x2F, false);
+		SimType(cursors_key[i & 3], true);	// remapped: journaled as delivered
+	}
+
+	SimIdle();
+	SIM_CHECK(HostCompleteIO() == 0 && SimFileRecords() == 0, "no write before the pause");
+
+	// the pause: idle time only queues the write
+	host_tick_count += SIM_PAUSE_TICKS;
+	SimIdle();
+	SIM_CHECK(SimFileRecords() == 0, "write started, not waited for");
+
+	// typing goes on while the write is in flight, and another idle doesn't start a second write
+	SimType(0x2F, false);
+	SimType(0x2F, false);
+	host_tick_count += SIM_PAUSE_TICKS;
+	SimIdle();
+	SIM_CHECK(HostCompleteIO() == 1 && SimFileRecords() == 20, "first write done, one write at a time");
+
+	host_tick_count += SIM_PAUSE_TICKS;
+	SimIdle();
+	SIM_CHECK(HostCompleteIO() == 1, "keys typed during the write go in the next one");
+	SimCheckFile("file after two writes", __LINE__);
+
+	// enough typing to fill half the ring and wrap it: two writes, in order
+	for (i = 0; i < 120; i++)
+	{
+		SimType((i & 1) ? 0x2F : cursors_key[i & 3], (i & 1) == 0);
+	}
+
+	SimIdle();
+	SIM_CHECK(HostCompleteIO() == 1, "first half of the wrapped ring");
+	SIM_CHECK(HostCompleteIO() == 1, "rest of the wrapped ring, chained by the completion");
+	SimCheckFile("file after the ring wrapped", __LINE__);
+
+	// stop while a write is in flight: idle time finishes the file
+	SimType(0x2F, false);
+	SimType(0x2F, false);
+	host_tick_count += SIM_PAUSE_TICKS;
+	SimIdle();
+	SimType(0x2F, false);
+	SIM_CHECK(CursorsStopRecording() == noErr && cursors_journal_state == JOURNAL_STOPPING, "stop with a write in flight");
+	SIM_CHECK(CursorsStartPlayback() == CURSORS_JOURNAL_ERR_BUSY, "no playback until the file is finished");
+	SimType(0x2F, false);
+	sim_delivered_count--;		// not recording any more
+	HostCompleteIO();
+	SimIdle();
+	HostCompleteIO();
+	SimIdle();
+	SIM_CHECK(cursors_journal_state == JOURNAL_OFF, "journal off once the last write is done");
+	SimCheckFile("file after stopping mid-write", __LINE__);
+
+	// more than one batch to play back
+	SIM_CHECK(CursorsStartPlayback() == noErr, "start a long playback");
+	SIM_CHECK(SimPlayBack() == sim_delivered_count && cursors_journal_state == JOURNAL_OFF, "every event played back, a batch at a time");
+	SIM_CHECK(host_last_posted.evtQMessage == sim_delivered[sim_delivered_count - 1].message, "last event of a long playback");
+
+	// stop with nothing in flight: written at once, at application time
+	sim_delivered_count = 0;
+	SIM_CHECK(CursorsStartRecording() == noErr && SimFileRecords() == 0, "restart recording");
+	SimType(cursors_key[0], true);
+	SimType(0x2F, false);
+	SimType(cursors_key[3], true);
+	SIM_CHECK(CursorsStopRecording() == noErr && cursors_journal_state == JOURNAL_OFF, "stop with nothing in flight");
+	SIM_CHECK(HostCompleteIO() == 0, "stop writes synchronously");
+	SimCheckFile("file after a quick stop", __LINE__);
+
+	// and it plays back what was delivered, one event per idle, once the
+	//  read of the file is done: idle time only starts it
+	host_posted_count = 0;
+	SIM_CHECK(CursorsStartPlayback() == noErr, "start playback");
+	SimIdle();
+	SimIdle();
+	SIM_CHECK(host_posted_count == 0 && HostCompleteIO() == 1, "playback reads the file asynchronously");
+
+	for (i = 0; i < 4; i++)
+	{
+		SimIdle();
+	}
+
+	SIM_CHECK(host_posted_count == 3 && cursors_journal_state == JOURNAL_OFF, "three events played back");
+	SIM_CHECK(host_last_posted.evtQMessage == sim_delivered[2].message && host_last_posted.evtQModifiers == sim_delivered[2].modifiers, "last event played back as delivered");
+
+	// another INIT joins our dispatcher: the journal holds what its handler
+	//  did to the events, and nothing it swallowed
+	SIM_CHECK(CursorsDispatchRegister(&cursors_dispatcher, SimLaterHandler), "later INIT joins");
+	sim_delivered_count = 0;
+	SIM_CHECK(CursorsStartRecording() == noErr, "record with a later handler");
+	SimType(SIM_LATER_CHANGES_KEY, false);
+	SimType(SIM_LATER_SWALLOWS_KEY, false);
+	SimType(cursors_key[1], true);
+	SimType(SIM_LATER_CHANGES_KEY, true);
+	SIM_CHECK(CursorsStopRecording() == noErr, "stop recording");
+	SIM_CHECK(sim_delivered_count == 3 && (sim_delivered[0].message & charCodeMask) == '!', "later handler ran");
+	SimCheckFile("journal holds the events after every handler", __LINE__);
+
+	// installed again, joining another INIT's dispatcher: no idle time
+	HostResetToolbox();
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)Gestalt, (int)GestaltTrap, OSTrap);
+	sim_other_dispatcher.version = CURSORS_DISPATCH_VERSION;
+	NewGestalt(CURSORS_DISPATCH_SELECTOR, (ProcPtr)SimOtherGestalt);
+	cursors_owns_trap = false;
+	CursorsInstall();
+	SIM_CHECK(sim_other_dispatcher.handler_count == 1 && sim_other_dispatcher.handler[0] == CursorsRemapKey
+		&& NGetTrapAddress((int)GetNextEventTrap, ToolTrap) == (long)SimROMGetNextEvent, "joined the other INIT's dispatcher");
+
+	// a long recording: the key path writes the ring out as it fills
+	sim_delivered_count = 0;
+	SIM_CHECK(CursorsStartRecording() == noErr, "record in the joined INIT");
+
+	for (i = 0; i < SIM_JOINED_KEYS; i++)
+	{
+		SimTypeJoined((i & 1) ? 0x2F : cursors_key[i & 3], (i & 1) == 0);
+
+		// the disk finishes a write every so often
+		if ((i & 15) == 15)
+		{
+			HostCompleteIO();
+		}
+	}
+
+	SIM_CHECK(SimFileRecords() >= SIM_JOINED_KEYS - SIM_RING_SIZE, "written while typing, with no idle time");
+
+	// on the Mac stopping would wait for a write in flight; here the harness is the disk
+	while (HostCompleteIO() > 0)
+	{
+	}
+
+	SIM_CHECK(CursorsStopRecording() == noErr && cursors_journal_state == JOURNAL_OFF, "stop in the joined INIT");
+	SIM_CHECK(sim_delivered_count == SIM_JOINED_KEYS, "every key delivered");
+	SimCheckFile("no key lost from a long recording without idle time", __LINE__);
+	SIM_CHECK(CursorsStartPlayback() == CURSORS_JOURNAL_ERR_NO_IDLE, "no playback without idle time");
+
+	if (sim_failures > 0)
+	{
+		fprintf(stderr, "journal_sim: %d check(s) FAILED\n", sim_failures);
+		return 1;
+	}
+
+	printf("journal_sim: all checks passed\n");
+	return 0;
+}
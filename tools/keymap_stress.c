@@ -0,0 +1,348 @@
+/*
+ * keymap_stress.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host stress test for the double-buffered keymap (cursors_keymap.c) under a
+ *  concurrent event stream, with the remap core (cursors_remap.c) reading
+ *  every table it pins.
+ *
+ * The Mac has one CPU, and "concurrent" there means an interrupt-time caller
+ *  (a VBL task, a driver completion) preempting the event path or an
+ *  application-time set_keymap. Two POSIX interval timers stand in for those
+ *  interrupts: their signal handlers call CursorsKeymapSet/Get at arbitrary
+ *  points in the main loop, and can interrupt each other, while the main loop
+ *  plays the event path (and now and then calls set_keymap at app time).
+ *
+ * Every table written has one generation number in every field, so a table
+ *  that changed while pinned, or was written by two setters at once, shows up
+ *  as mixed generations.
+ *
+ * Usage: keymap_stress [seconds]     (default 1)
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+
+// C includes
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define STRESS_KEY_FIRST			0x10	// key codes mapped: 0x10 - 0x13
+#define STRESS_SPIN					64		// reads per field while pinned, to widen the window
+#define STRESS_APP_SET_EVERY		16		// event path iterations between app-time sets
+#define STRESS_TIMER_A_USEC			37		// odd periods, so the two drift across each other
+#define STRESS_TIMER_B_USEC			53
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static CursorsKeymapTables		stress_tables;
+static volatile uint32_t		stress_generation = 0;
+
+static volatile uint32_t		stress_irq_sets = 0;
+static volatile uint32_t		stress_irq_busy = 0;
+static volatile uint32_t		stress_irq_gets = 0;
+static volatile uint32_t		stress_prof_ticks = 0;		// SIGPROF alternates get and set
+static volatile uint32_t		stress_irq_torn = 0;
+static uint32_t					stress_app_sets = 0;
+static uint32_t					stress_app_busy = 0;
+static uint32_t					stress_events = 0;
+static uint32_t					stress_torn = 0;
+static uint32_t					stress_wrong_remap = 0;
+static uint32_t					stress_swaps_seen = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Fills in a mapping with one generation number in every field
+static void StressMakeMap(CursorsKeymap *map, uint32_t generation);
+
+// Checks that every field of a mapping is from the same generation
+// @return	Returns true if the mapping is whole
+static bool StressMapIsWhole(const CursorsKeymap *map);
+
+// The "interrupt": set_keymap, or get_keymap, at an arbitrary point
+static void StressInterrupt(int signal_number);
+
+// Checks the deterministic cases: busy and in-use spare are refused, untouched
+// @return	Returns the number of failed checks
+static int StressCheckRefusals(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Fills in a mapping with one generation number in every field
+static void StressMakeMap(CursorsKeymap *map, uint32_t generation)
+{
+	int		i;
+	uint8_t	g = (uint8_t)(generation & 0xFF);
+
+	for (i = 0; i < CURSORS_NUM_KEYS; i++)
+	{
+		map->key[i] = STRESS_KEY_FIRST + i;
+		map->remap[i] = (uint16_t)(g << 8) | (0x80 + i);	// never 0: 0 means "no remap"
+	}
+
+	map->modifier_choice = MODIFIER_OPT_KEY;
+	map->reserved = g;
+}
+
+
+// Checks that every field of a mapping is from the same generation
+// @return	Returns true if the mapping is whole
+static bool StressMapIsWhole(const CursorsKeymap *map)
+{
+	const volatile CursorsKeymap*	v_map = map;
+	uint8_t		g;
+	int			i;
+	int			spin;
+
+	g = v_map->reserved;
+
+	for (spin = 0; spin < STRESS_SPIN; spin++)
+	{
+		for (i = 0; i < CURSORS_NUM_KEYS; i++)
+		{
+			if (v_map->key[i] != STRESS_KEY_FIRST + i || (v_map->remap[i] >> 8) != g || (v_map->remap[i] & 0xFF) != 0x80 + i)
+			{
+				return false;
+			}
+		}
+
+		if (v_map->modifier_choice != MODIFIER_OPT_KEY || v_map->reserved != g)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// The "interrupt": set_keymap, or get_keymap, at an arbitrary point
+static void StressInterrupt(int signal_number)
+{
+	CursorsKeymap	the_map;
+	OSErr			the_err;
+
+	if (signal_number == SIGPROF && (++stress_prof_ticks & 1))
+	{
+		stress_irq_gets++;
+
+		if (CursorsKeymapGet(&stress_tables, &the_map) == noErr && !StressMapIsWhole(&the_map))
+		{
+			stress_irq_torn++;
+		}
+
+		return;
+	}
+
+	StressMakeMap(&the_map, ++stress_generation);
+	the_err = CursorsKeymapSet(&stress_tables, &the_map);
+
+	if (the_err == noErr)
+	{
+		stress_irq_sets++;
+	}
+	else if (the_err == CURSORS_KEYMAP_ERR_BUSY)
+	{
+		stress_irq_busy++;
+	}
+}
+
+
+// Checks the deterministic cases: busy and in-use spare are refused, untouched
+// @return	Returns the number of failed checks
+static int StressCheckRefusals(void)
+{
+	CursorsKeymapTables	tables;
+	CursorsKeymap		the_map;
+	CursorsKeymap		saved[2];
+	int					failures = 0;
+
+	StressMakeMap(&the_map, 1);
+	CursorsKeymapInit(&tables, &the_map);
+	memcpy(saved, tables.table, sizeof(saved));
+
+	// a set or get that interrupted another one
+	tables.busy = true;
+	StressMakeMap(&the_map, 2);
+	failures += (CursorsKeymapSet(&tables, &the_map) != CURSORS_KEYMAP_ERR_BUSY);
+	failures += (CursorsKeymapGet(&tables, &the_map) != CURSORS_KEYMAP_ERR_BUSY);
+	failures += (memcmp(saved, tables.table, sizeof(saved)) != 0);
+	failures += (tables.active != &tables.table[0] || !tables.busy);
+	tables.busy = false;
+
+	// the event path still reads the spare, right after a swap
+	StressMakeMap(&the_map, 3);
+	failures += (CursorsKeymapSet(&tables, &the_map) != noErr);
+	tables.in_use = &tables.table[0];
+	memcpy(saved, tables.table, sizeof(saved));
+	StressMakeMap(&the_map, 4);
+	failures += (CursorsKeymapSet(&tables, &the_map) != CURSORS_KEYMAP_ERR_BUSY);
+	failures += (memcmp(saved, tables.table, sizeof(saved)) != 0 || tables.busy);
+	tables.in_use = NULL;
+
+	// and an invalid mapping
+	the_map.modifier_choice = MODIFIER_CAPSLOCK_MODE_2 + 1;
+	failures += (CursorsKeymapSet(&tables, &the_map) != paramErr);
+
+	if (failures > 0)
+	{
+		fprintf(stderr, "FAIL: %d refusal check(s)\n", failures);
+	}
+
+	return failures;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	struct sigaction	the_action;
+	struct itimerval	the_timer;
+	CursorsRemapState	the_state = {0, false};
+	CursorsKeymap		the_map;
+	EventRecord			the_event;
+	const CursorsKeymap*	map;
+	const CursorsKeymap*	last_map = NULL;
+	time_t				end_time;
+	double				seconds = 1.0;
+	int					k;
+	int					failures;
+
+	if (argc > 1)
+	{
+		seconds = atof(argv[1]);
+	}
+
+	failures = StressCheckRefusals();
+
+	StressMakeMap(&the_map, 0);
+	CursorsKeymapInit(&stress_tables, &the_map);
+
+	// the two "interrupt sources" may nest: each one's handler only blocks itself
+	memset(&the_action, 0, sizeof(the_action));
+	the_action.sa_handler = StressInterrupt;
+	sigemptyset(&the_action.sa_mask);
+	sigaction(SIGALRM, &the_action, NULL);
+	sigaction(SIGPROF, &the_action, NULL);
+
+	memset(&the_timer, 0, sizeof(the_timer));
+	the_timer.it_interval.tv_usec = the_timer.it_value.tv_usec = STRESS_TIMER_A_USEC;
+	setitimer(ITIMER_REAL, &the_timer, NULL);
+	the_timer.it_interval.tv_usec = the_timer.it_value.tv_usec = STRESS_TIMER_B_USEC;
+	setitimer(ITIMER_PROF, &the_timer, NULL);
+
+	end_time = time(NULL) + (time_t)(seconds + 0.999);
+
+	while (time(NULL) < end_time)
+	{
+		// the event path, exactly as CursorsRemapKey does it
+		k = stress_events % CURSORS_NUM_KEYS;
+		memset(&the_event, 0, sizeof(the_event));
+		the_event.what = keyDown;
+		the_event.message = ((STRESS_KEY_FIRST + k) << 8) | 'x';
+		the_event.modifiers = optionKey;
+
+		map = CursorsKeymapPin(&stress_tables);
+
+		if (!StressMapIsWhole(map))
+		{
+			stress_torn++;
+		}
+
+		CursorsRemapEvent(&the_event, map, &the_state);
+
+		// the event must come out exactly as the pinned table says
+		if ((the_event.message & 0xFFFF) != map->remap[k] || !StressMapIsWhole(map))
+		{
+			stress_wrong_remap++;
+		}
+
+		CursorsKeymapUnpin(&stress_tables);
+
+		stress_swaps_seen += (map != last_map);
+		last_map = map;
+		stress_events++;
+
+		// and sometimes the companion app, at application time
+		if (stress_events % STRESS_APP_SET_EVERY == 0)
+		{
+			StressMakeMap(&the_map, ++stress_generation);
+
+			if (CursorsKeymapSet(&stress_tables, &the_map) == noErr)
+			{
+				stress_app_sets++;
+			}
+			else
+			{
+				stress_app_busy++;
+			}
+		}
+	}
+
+	memset(&the_timer, 0, sizeof(the_timer));
+	setitimer(ITIMER_REAL, &the_timer, NULL);
+	setitimer(ITIMER_PROF, &the_timer, NULL);
+
+	printf("events %u, table swaps seen by event path %u\n", stress_events, stress_swaps_seen);
+	printf("interrupt sets %u (busy %u), interrupt gets %u, app sets %u (busy %u)\n",
+		stress_irq_sets, stress_irq_busy, stress_irq_gets, stress_app_sets, stress_app_busy);
+	printf("torn tables: event path %u, get_keymap %u; wrong remaps %u\n", stress_torn, stress_irq_torn, stress_wrong_remap);
+
+	if (stress_torn > 0 || stress_irq_torn > 0 || stress_wrong_remap > 0)
+	{
+		failures++;
+	}
+
+	if (stress_irq_sets == 0 || stress_swaps_seen < 2)
+	{
+		fprintf(stderr, "FAIL: interrupts never swapped a table, nothing was tested\n");
+		failures++;
+	}
+
+	if (failures > 0)
+	{
+		fprintf(stderr, "keymap_stress: FAILED\n");
+		return 1;
+	}
+
+	printf("keymap_stress: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * remap_batch.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Batch form of the remap core, for host tools. See remap_batch.h.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "remap_batch.h"
+
+// C includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if CURSORS_BATCH_USE_SSE2
+	#include <emmintrin.h>
+#endif
+
+// Platform includes
+#include <Events.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define BATCH_BLOCK					8		// events tested at once: 8 x 16 bytes, one mask bit each
+
+// the SSE2 test reads 'what' from word 0 and 'modifiers' from word 7 of each
+//  16 byte event: host EventRecords keep the 68k layout (cursors_host.h)
+typedef char batch_check_event_size[(sizeof(EventRecord) == 16) ? 1 : -1];
+typedef char batch_check_what[(offsetof(EventRecord, what) == 0) ? 1 : -1];
+typedef char batch_check_modifiers[(offsetof(EventRecord, modifiers) == 14) ? 1 : -1];
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Works out how to tell, from the modifiers alone, that the map's modifier is down
+static void BatchModifierTest(const CursorsKeymap *map, uint16_t *mask, uint16_t *down);
+
+#if CURSORS_BATCH_USE_SSE2
+// Tests BATCH_BLOCK events at once: bit i of each mask is event i
+// @param	key_mask: set to the key events
+// @param	down_mask: set to the key events with the modifier down
+static void BatchBlockMasks(const EventRecord *events, __m128i mask, __m128i down, unsigned int *key_mask, unsigned int *down_mask);
+#endif
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Works out how to tell, from the modifiers alone, that the map's modifier is down
+static void BatchModifierTest(const CursorsKeymap *map, uint16_t *mask, uint16_t *down)
+{
+	// LOGIC:
+	//   "down" here means CursorsRemapEvent() has to see the event. for the
+	//   two single-modifier choices that is the modifier's bit. capslock mode 2
+	//   changes every key event (it unshifts letters), so for it every key
+	//   event counts as down: (m & 0) == 0. any other byte means the modifier
+	//   is never down: (m & 0) == 1 is never true.
+
+	switch (map->modifier_choice)
+	{
+		case MODIFIER_OPT_KEY:
+			*mask = *down = optionKey;
+			break;
+
+		case MODIFIER_CAPSLOCK_MODE_1:
+			*mask = *down = alphaLock;
+			break;
+
+		case MODIFIER_CAPSLOCK_MODE_2:
+			*mask = *down = 0;
+			break;
+
+		default:
+			*mask = 0;
+			*down = 1;
+			break;
+	}
+}
+
+
+#if CURSORS_BATCH_USE_SSE2
+// Tests BATCH_BLOCK events at once: bit i of each mask is event i
+// @param	key_mask: set to the key events
+// @param	down_mask: set to the key events with the modifier down
+static void BatchBlockMasks(const EventRecord *events, __m128i mask, __m128i down, unsigned int *key_mask, unsigned int *down_mask)
+{
+	const __m128i*	block = (const __m128i*)events;
+	__m128i			low[BATCH_BLOCK / 2];
+	__m128i			high[BATCH_BLOCK / 2];
+	__m128i			what;
+	__m128i			modifiers;
+	__m128i			is_key;
+	__m128i			is_down;
+	int				i;
+
+	// LOGIC:
+	//   'what' is word 0 and 'modifiers' word 7 of each 16 byte event. three
+	//   rounds of unpacking gather the 8 'what's into one register and the 8
+	//   'modifiers' into another, one word per event, in order:
+	//     16 bit: words 0 and 7 of events 2i and 2i+1 end up side by side
+	//     32 bit: those pairs, for events 0-3 and 4-7
+	//     64 bit: both halves
+	//   then the compares run once for the whole block, and packing the
+	//   results to bytes gives one movemask bit per event
+
+	for (i = 0; i < BATCH_BLOCK / 2; i++)
+	{
+		low[i] = _mm_unpacklo_epi16(_mm_loadu_si128(&block[2 * i]), _mm_loadu_si128(&block[2 * i + 1]));
+		high[i] = _mm_unpackhi_epi16(_mm_loadu_si128(&block[2 * i]), _mm_loadu_si128(&block[2 * i + 1]));
+	}
+
+	// whats: dword 0 of each low[i]; modifiers: dword 3 of each high[i]
+	what = _mm_unpacklo_epi64(_mm_unpacklo_epi32(low[0], low[1]), _mm_unpacklo_epi32(low[2], low[3]));
+	modifiers = _mm_unpackhi_epi64(_mm_unpackhi_epi32(high[0], high[1]), _mm_unpackhi_epi32(high[2], high[3]));
+
+	is_key = _mm_or_si128(_mm_cmpeq_epi16(what, _mm_set1_epi16(keyDown)), _mm_cmpeq_epi16(what, _mm_set1_epi16(autoKey)));
+	is_down = _mm_and_si128(is_key, _mm_cmpeq_epi16(_mm_and_si128(modifiers, mask), down));
+
+	*key_mask = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(is_key, _mm_setzero_si128()));
+	*down_mask = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(is_down, _mm_setzero_si128()));
+}
+#endif
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+// Remaps every key event in an array, as CursorsRemapEvent() would one by
+//   one. Other events pass through untouched, as they do in the INIT
+// @param	events: the events, in the order they were delivered; modified
+// @param	num_events: how many
+// @param	map: the key mapping to apply
+// @param	state: repeat tracking for this instance; updated
+void CursorsRemapEvents(EventRecord *events, size_t num_events, const CursorsKeymap *map, CursorsRemapState *state)
+{
+	EventRecord*	the_event;
+	uint16_t		mask;
+	uint16_t		down;
+	size_t			i = 0;
+#if CURSORS_BATCH_USE_SSE2
+	__m128i			mask_v;
+	__m128i			down_v;
+	unsigned int	key_mask;
+	unsigned int	down_mask;
+#endif
+
+	// LOGIC:
+	//   CursorsRemapEvent() leaves a key event, and the state, alone when the
+	//   modifier is not down and no repeat chain is open (last_event_was_remap
+	//   false): it would only set last_event_was_remap to false again. so
+	//   while no chain is open, such key events, and all other events, are
+	//   skipped; everything else goes through CursorsRemapEvent() itself, so
+	//   the output is the same byte for byte.
+
+	BatchModifierTest(map, &mask, &down);
+
+#if CURSORS_BATCH_USE_SSE2
+	mask_v = _mm_set1_epi16((short)mask);
+	down_v = _mm_set1_epi16((short)down);
+
+	// whole blocks. CursorsRemapEvent() only changes the event it is given,
+	//  so the block's masks hold while its events are remapped
+	for (; i + BATCH_BLOCK <= num_events; i += BATCH_BLOCK)
+	{
+		BatchBlockMasks(&events[i], mask_v, down_v, &key_mask, &down_mask);
+
+		// the common case: nothing in the block for the remap core
+		if (down_mask == 0 && !state->last_event_was_remap)
+		{
+			continue;
+		}
+
+		for (; key_mask != 0; key_mask &= key_mask - 1)
+		{
+			// no chain open: on to the next key event with the modifier down
+			if (!state->last_event_was_remap)
+			{
+				if ((key_mask & down_mask) == 0)
+				{
+					break;
+				}
+
+				key_mask &= ~0u << __builtin_ctz(key_mask & down_mask);
+			}
+
+			CursorsRemapEvent(&events[i + __builtin_ctz(key_mask)], map, state);
+		}
+	}
+#endif
+
+	// the rest, or all of it without SSE2
+	while (i < num_events)
+	{
+		the_event = &events[i++];
+
+		if (the_event->what != keyDown && the_event->what != autoKey)
+		{
+			continue;
+		}
+
+		if (state->last_event_was_remap || (uint16_t)(the_event->modifiers & mask) == down)
+		{
+			CursorsRemapEvent(the_event, map, state);
+		}
+	}
+}
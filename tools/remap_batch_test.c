@@ -0,0 +1,456 @@
+/*
+ * remap_batch_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host test and benchmark of CursorsRemapEvents() (remap_batch.c) against
+ *  the one-event-at-a-time loop it replaces: CursorsRemapEvent() on every
+ *  key event, in order.
+ *
+ * First runs random event streams through both, for every modifier choice,
+ *  at lengths around the 8-event SSE2 block, and checks that the events and
+ *  the repeat state come out byte for byte the same. Then prints events/s of
+ *  both on two streams: a whole session as GetNextEvent sees it (mostly null
+ *  events) and a journal (key events only).
+ *
+ * With -g, it streams a trace of that many gigabytes through both instead,
+ *  one 16 MB chunk at a time, as a tool reading a trace from disk would. The
+ *  repeat state carries over from chunk to chunk, the output of both is
+ *  compared chunk by chunk, and only the remapping is timed. Both run on each
+ *  chunk in turn, so a busy machine slows them alike. The chunks come from a
+ *  pool of four, larger than the caches, so the trace is not all the same
+ *  16 MB. `make test` doesn't run it: 4 GB takes several seconds.
+ *
+ * The Makefile builds it twice, as remap_batch_test (plain C batch) and
+ *  remap_batch_test_sse2 (SSE2 batch, where the host has it), so both are
+ *  checked.
+ *
+ * Usage: remap_batch_test [events]     (default 1000000 per benchmark)
+ *        remap_batch_test -g gigabytes
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+#include "remap_batch.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_NUM_MAPS				5
+#define TEST_STREAMS_PER_MAP		200
+#define TEST_MAX_STREAM				67		// odd, so every remainder of the block is hit
+#define TEST_DEFAULT_EVENTS			1000000
+#define TEST_BENCH_RUNS				9		// best of
+
+#define TEST_MIX_SESSION			0		// 1 in 8 events is a key event
+#define TEST_MIX_JOURNAL			1		// key events only
+#define NUM_TEST_MIXES				2
+
+#define TEST_CHUNK_EVENTS			(1024 * 1024)	// 16 MB
+#define TEST_CHUNK_POOL				4
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static const CursorsKeymap	test_maps[TEST_NUM_MAPS] =
+{
+	{{0x5B, 0x56, 0x57, 0x58}, MODIFIER_OPT_KEY, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x5B, 0x56, 0x57, 0x58}, MODIFIER_CAPSLOCK_MODE_1, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x0D, 0x00, 0x01, 0x02}, MODIFIER_CAPSLOCK_MODE_2, 0, {0x7E1E, 0x7B1C, 0x7D1F, 0x7C1D}},
+	{{0x5B, 0x56, 0x5B, 0x58}, MODIFIER_OPT_KEY, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x5B, 0x56, 0x57, 0x58}, MODIFIER_CAPSLOCK_MODE_2 + 1, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+};
+
+static const char*		test_mix_name[NUM_TEST_MIXES] =
+{
+	"session",
+	"journal",
+};
+
+static uint32_t			test_random = 1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Small LCG, so every run sees the same streams
+static uint32_t TestRandom(void);
+
+// Fills in a stream of events
+// @param	key_every: 1 in this many events is a key event
+// @param	modifier_every: 1 in this many key events has modifiers held
+static void TestMakeStream(EventRecord *events, size_t num_events, int key_every, int modifier_every);
+
+// The loop CursorsRemapEvents() replaces
+static void TestRemapOneByOne(EventRecord *events, size_t num_events, const CursorsKeymap *map, CursorsRemapState *state);
+
+// Runs random streams through both, for every map
+// @return	Returns the number of streams that came out different
+static int TestEquivalence(void);
+
+// @return	Returns the best events/s of TEST_BENCH_RUNS runs
+static double TestBench(const EventRecord *stream, EventRecord *work, size_t num_events, bool batch);
+
+// @return	Returns the seconds since start
+static double TestSeconds(const struct timespec *start);
+
+// Streams a trace of some gigabytes through both, a chunk at a time
+// @return	Returns the number of chunks that came out different
+static int TestStream(double gigabytes);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Small LCG, so every run sees the same streams
+static uint32_t TestRandom(void)
+{
+	test_random = test_random * 1103515245 + 12345;
+	return (test_random >> 8);
+}
+
+
+// Fills in a stream of events
+// @param	key_every: 1 in this many events is a key event
+// @param	modifier_every: 1 in this many key events has modifiers held
+static void TestMakeStream(EventRecord *events, size_t num_events, int key_every, int modifier_every)
+{
+	// mapped keys of every test map, and some that are not
+	static const uint8_t	keys[] = {0x5B, 0x56, 0x57, 0x58, 0x0D, 0x00, 0x01, 0x02, 0x0C, 0x12, 0x2F};
+	static const int16_t	others[] = {nullEvent, nullEvent, nullEvent, mouseDown, mouseUp, keyUp};
+	static const int16_t	modifiers[] = {optionKey, alphaLock, alphaLock | shiftKey, shiftKey, optionKey | shiftKey};
+	size_t		i;
+	uint8_t		the_key;
+
+	for (i = 0; i < num_events; i++)
+	{
+		memset(&events[i], 0, sizeof(EventRecord));
+		events[i].when = (int32_t)i;
+
+		if (TestRandom() % key_every != 0)
+		{
+			events[i].what = others[TestRandom() % (sizeof(others) / sizeof(others[0]))];
+			continue;
+		}
+
+		the_key = keys[TestRandom() % sizeof(keys)];
+		events[i].what = (TestRandom() % 3 == 0) ? autoKey : keyDown;
+		events[i].message = (the_key << 8) | ('A' + TestRandom() % 40);
+
+		if (TestRandom() % modifier_every == 0)
+		{
+			events[i].modifiers = modifiers[TestRandom() % (sizeof(modifiers) / sizeof(modifiers[0]))];
+		}
+	}
+}
+
+
+// The loop CursorsRemapEvents() replaces
+static void TestRemapOneByOne(EventRecord *events, size_t num_events, const CursorsKeymap *map, CursorsRemapState *state)
+{
+	size_t		i;
+
+	for (i = 0; i < num_events; i++)
+	{
+		if (events[i].what == keyDown || events[i].what == autoKey)
+		{
+			CursorsRemapEvent(&events[i], map, state);
+		}
+	}
+}
+
+
+// Runs random streams through both, for every map
+// @return	Returns the number of streams that came out different
+static int TestEquivalence(void)
+{
+	EventRecord			one_by_one[TEST_MAX_STREAM];
+	EventRecord			batch[TEST_MAX_STREAM];
+	CursorsRemapState	one_by_one_state;
+	CursorsRemapState	batch_state;
+	size_t				num_events;
+	int					m;
+	int					s;
+	int					failures = 0;
+
+	for (m = 0; m < TEST_NUM_MAPS; m++)
+	{
+		for (s = 0; s < TEST_STREAMS_PER_MAP; s++)
+		{
+			num_events = s % (TEST_MAX_STREAM + 1);
+			TestMakeStream(one_by_one, num_events, 1 + s % 4, 1 + s % 3);
+			memcpy(batch, one_by_one, sizeof(one_by_one));
+
+			// start some streams in the middle of a repeat chain
+			one_by_one_state.last_remapped_key = test_maps[m].key[s % CURSORS_NUM_KEYS];
+			one_by_one_state.last_event_was_remap = (s % 5 == 0);
+			batch_state = one_by_one_state;
+
+			TestRemapOneByOne(one_by_one, num_events, &test_maps[m], &one_by_one_state);
+			CursorsRemapEvents(batch, num_events, &test_maps[m], &batch_state);
+
+			if (memcmp(one_by_one, batch, sizeof(one_by_one)) != 0
+				|| one_by_one_state.last_remapped_key != batch_state.last_remapped_key
+				|| one_by_one_state.last_event_was_remap != batch_state.last_event_was_remap)
+			{
+				fprintf(stderr, "FAIL: map %d, stream %d (%u events) came out different\n", m, s, (unsigned)num_events);
+				failures++;
+			}
+		}
+	}
+
+	return failures;
+}
+
+
+// @return	Returns the best events/s of TEST_BENCH_RUNS runs
+static double TestBench(const EventRecord *stream, EventRecord *work, size_t num_events, bool batch)
+{
+	CursorsRemapState	the_state;
+	struct timespec		start;
+	struct timespec		end;
+	double				seconds;
+	double				best = 0;
+	int					run;
+
+	for (run = 0; run < TEST_BENCH_RUNS; run++)
+	{
+		memcpy(work, stream, num_events * sizeof(EventRecord));
+		the_state.last_remapped_key = 0;
+		the_state.last_event_was_remap = false;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		if (batch)
+		{
+			CursorsRemapEvents(work, num_events, &test_maps[0], &the_state);
+		}
+		else
+		{
+			TestRemapOneByOne(work, num_events, &test_maps[0], &the_state);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+		if (run == 0 || num_events / seconds > best)
+		{
+			best = num_events / seconds;
+		}
+	}
+
+	return best;
+}
+
+
+
+// @return	Returns the seconds since start
+static double TestSeconds(const struct timespec *start)
+{
+	struct timespec		end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+// Streams a trace of some gigabytes through both, a chunk at a time
+// @return	Returns the number of chunks that came out different
+static int TestStream(double gigabytes)
+{
+	EventRecord*		pool[NUM_TEST_MIXES][TEST_CHUNK_POOL];
+	EventRecord*		one_by_one;
+	EventRecord*		batch;
+	CursorsRemapState	one_by_one_state;
+	CursorsRemapState	batch_state;
+	struct timespec		start;
+	double				seconds[2];
+	size_t				chunk_bytes = TEST_CHUNK_EVENTS * sizeof(EventRecord);
+	long				num_chunks = (long)(gigabytes * 1e9 / chunk_bytes + 0.5);
+	long				c;
+	int					mix;
+	int					p;
+	int					failures = 0;
+
+	one_by_one = malloc(chunk_bytes);
+	batch = malloc(chunk_bytes);
+
+	for (mix = 0; mix < NUM_TEST_MIXES; mix++)
+	{
+		for (p = 0; p < TEST_CHUNK_POOL; p++)
+		{
+			pool[mix][p] = malloc(chunk_bytes);
+
+			if (pool[mix][p] == NULL)
+			{
+				fprintf(stderr, "remap_batch_test: out of memory\n");
+				exit(1);
+			}
+
+			TestMakeStream(pool[mix][p], TEST_CHUNK_EVENTS, (mix == TEST_MIX_SESSION) ? 8 : 1, 10);
+		}
+	}
+
+	if (one_by_one == NULL || batch == NULL || num_chunks < 1)
+	{
+		fprintf(stderr, "remap_batch_test: out of memory, or no trace\n");
+		exit(1);
+	}
+
+#if CURSORS_BATCH_USE_SSE2
+	printf("%-10s %14s %14s   (host Mevents/s, %.1f GB streamed, option map, SSE2 batch)\n", "", "one by one", "batch", num_chunks * chunk_bytes / 1e9);
+#else
+	printf("%-10s %14s %14s   (host Mevents/s, %.1f GB streamed, option map, plain C batch)\n", "", "one by one", "batch", num_chunks * chunk_bytes / 1e9);
+#endif
+
+	for (mix = 0; mix < NUM_TEST_MIXES; mix++)
+	{
+		memset(&one_by_one_state, 0, sizeof(one_by_one_state));
+		memset(&batch_state, 0, sizeof(batch_state));
+		seconds[0] = seconds[1] = 0;
+
+		for (c = 0; c < num_chunks; c++)
+		{
+			// the read from disk, not timed
+			memcpy(one_by_one, pool[mix][c % TEST_CHUNK_POOL], chunk_bytes);
+			memcpy(batch, pool[mix][c % TEST_CHUNK_POOL], chunk_bytes);
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			TestRemapOneByOne(one_by_one, TEST_CHUNK_EVENTS, &test_maps[0], &one_by_one_state);
+			seconds[0] += TestSeconds(&start);
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			CursorsRemapEvents(batch, TEST_CHUNK_EVENTS, &test_maps[0], &batch_state);
+			seconds[1] += TestSeconds(&start);
+
+			if (memcmp(one_by_one, batch, chunk_bytes) != 0
+				|| one_by_one_state.last_remapped_key != batch_state.last_remapped_key
+				|| one_by_one_state.last_event_was_remap != batch_state.last_event_was_remap)
+			{
+				fprintf(stderr, "FAIL: %s chunk %ld came out different\n", test_mix_name[mix], c);
+				failures++;
+			}
+		}
+
+		printf("%-10s %14.1f %14.1f\n", test_mix_name[mix],
+			num_chunks * TEST_CHUNK_EVENTS / seconds[0] / 1e6, num_chunks * TEST_CHUNK_EVENTS / seconds[1] / 1e6);
+	}
+
+	for (mix = 0; mix < NUM_TEST_MIXES; mix++)
+	{
+		for (p = 0; p < TEST_CHUNK_POOL; p++)
+		{
+			free(pool[mix][p]);
+		}
+	}
+
+	free(one_by_one);
+	free(batch);
+
+	return failures;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	EventRecord*	stream;
+	EventRecord*	work;
+	size_t			num_events = TEST_DEFAULT_EVENTS;
+	double			one_by_one_rate;
+	double			batch_rate;
+	int				failures;
+	int				mix;
+
+	failures = TestEquivalence();
+
+	if (argc > 2 && strcmp(argv[1], "-g") == 0)
+	{
+		failures += TestStream(atof(argv[2]));
+
+		if (failures > 0)
+		{
+			fprintf(stderr, "remap_batch_test: %d stream(s) or chunk(s) FAILED\n", failures);
+			return 1;
+		}
+
+		printf("remap_batch_test: batch and one-by-one agree on %d streams and the whole trace\n", TEST_NUM_MAPS * TEST_STREAMS_PER_MAP);
+		return 0;
+	}
+
+	if (argc > 1)
+	{
+		num_events = (size_t)atol(argv[1]);
+	}
+
+	stream = malloc(num_events * sizeof(EventRecord));
+	work = malloc(num_events * sizeof(EventRecord));
+
+	if (stream == NULL || work == NULL)
+	{
+		fprintf(stderr, "remap_batch_test: out of memory\n");
+		return 1;
+	}
+
+#if CURSORS_BATCH_USE_SSE2
+	printf("%-10s %14s %14s   (host Mevents/s, option map, SSE2 batch)\n", "", "one by one", "batch");
+#else
+	printf("%-10s %14s %14s   (host Mevents/s, option map, plain C batch)\n", "", "one by one", "batch");
+#endif
+
+	for (mix = 0; mix < NUM_TEST_MIXES; mix++)
+	{
+		// 1 in 10 key events with a modifier held, in both
+		TestMakeStream(stream, num_events, (mix == TEST_MIX_SESSION) ? 8 : 1, 10);
+
+		one_by_one_rate = TestBench(stream, work, num_events, false);
+		batch_rate = TestBench(stream, work, num_events, true);
+
+		printf("%-10s %14.1f %14.1f\n", test_mix_name[mix], one_by_one_rate / 1e6, batch_rate / 1e6);
+	}
+
+	free(stream);
+	free(work);
+
+	if (failures > 0)
+	{
+		fprintf(stderr, "remap_batch_test: %d stream(s) FAILED\n", failures);
+		return 1;
+	}
+
+	printf("remap_batch_test: batch and one-by-one agree on %d streams\n", TEST_NUM_MAPS * TEST_STREAMS_PER_MAP);
+	return 0;
+}
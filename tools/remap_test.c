@@ -0,0 +1,153 @@
+/*
+ * remap_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host test of the remap core (cursors_remap.c): one table of key events in,
+ *  the events an application should get out, for each modifier choice and
+ *  for the letter layouts the INIT offers (WASD), where capslock mode 2's
+ *  unshift used to write the typed letter back over the cursor key.
+ *
+ * Cases run in order through one CursorsRemapState, so autoKey cases see
+ *  the keyDown before them.
+ *
+ * Usage: remap_test
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define NUM_TEST_MAPS				5
+
+#define TEST_MAP_WASD_MODE_2		0	// the WASD layout, with the default modifier choice
+#define TEST_MAP_WASD_OPTION		1
+#define TEST_MAP_NUMPAD_MODE_1		2	// the 1.0 ResEdit layout: numpad 8456
+#define TEST_MAP_SAME_KEY_TWICE		3	// keypad 8 listed for up and for down: the last one wins
+#define TEST_MAP_BAD_MODIFIER		4	// a modifier byte out of range, as ResEdit allows: never down
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct RemapTestCase
+{
+	const char*	name;
+	int			map;
+	int16_t		what;
+	int32_t		message_in;
+	int16_t		modifiers_in;
+	int32_t		message_out;
+	int16_t		modifiers_out;
+} RemapTestCase;
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// what CursorsInstall() builds for these layouts on an ADB keyboard
+static const CursorsKeymap	test_maps[NUM_TEST_MAPS] =
+{
+	{{0x0D, 0x00, 0x01, 0x02}, MODIFIER_CAPSLOCK_MODE_2, 0, {0x7E1E, 0x7B1C, 0x7D1F, 0x7C1D}},
+	{{0x0D, 0x00, 0x01, 0x02}, MODIFIER_OPT_KEY, 0, {0x7E1E, 0x7B1C, 0x7D1F, 0x7C1D}},
+	{{0x5B, 0x56, 0x57, 0x58}, MODIFIER_CAPSLOCK_MODE_1, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x5B, 0x56, 0x5B, 0x58}, MODIFIER_OPT_KEY, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x5B, 0x56, 0x57, 0x58}, MODIFIER_CAPSLOCK_MODE_2 + 1, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+};
+
+static const RemapTestCase	test_cases[] =
+{
+	// WASD, capslock mode 2: the remapped key keeps its cursor char
+	{"W, caps",					TEST_MAP_WASD_MODE_2,	keyDown,	0x0D57, alphaLock,				0x7E1E, 0},
+	{"W repeat",				TEST_MAP_WASD_MODE_2,	autoKey,	0x0D57, 0,						0x7E1E, 0},
+	{"A, caps+shift",			TEST_MAP_WASD_MODE_2,	keyDown,	0x0041, alphaLock | shiftKey,	0x7B1C, shiftKey},
+	{"Q, caps: unshifted",		TEST_MAP_WASD_MODE_2,	keyDown,	0x0C51, alphaLock,				0x0C71, 0},
+	{"Q, caps+shift: kept",		TEST_MAP_WASD_MODE_2,	keyDown,	0x0C51, alphaLock | shiftKey,	0x0C51, shiftKey},
+	{"1, caps: not a letter",	TEST_MAP_WASD_MODE_2,	keyDown,	0x1231, alphaLock,				0x1231, 0},
+	{"w, no caps",				TEST_MAP_WASD_MODE_2,	keyDown,	0x0D77, 0,						0x0D77, 0},
+	{"w repeat, no caps",		TEST_MAP_WASD_MODE_2,	autoKey,	0x0D77, 0,						0x0D77, 0},
+
+	// WASD, option
+	{"S, no option",			TEST_MAP_WASD_OPTION,	keyDown,	0x0173, 0,						0x0173, 0},
+	{"opt-S",					TEST_MAP_WASD_OPTION,	keyDown,	0x01A7, optionKey,				0x7D1F, 0},
+	{"S repeat",				TEST_MAP_WASD_OPTION,	autoKey,	0x01A7, 0,						0x7D1F, 0},
+	{"opt-Q",					TEST_MAP_WASD_OPTION,	keyDown,	0x0CCF, optionKey,				0x0CCF, optionKey},
+
+	// numpad, capslock mode 1: caps behaves as usual on other keys
+	{"keypad 6, caps",			TEST_MAP_NUMPAD_MODE_1,	keyDown,	0x5836, alphaLock,				0x421D, 0},
+	{"Q, caps: kept",			TEST_MAP_NUMPAD_MODE_1,	keyDown,	0x0C51, alphaLock,				0x0C51, alphaLock},
+
+	// a key listed twice, as the ResEdit bytes allow: same as 1.0, last one wins
+	{"opt-keypad 8, twice",		TEST_MAP_SAME_KEY_TWICE,	keyDown,	0x5BB8, optionKey,			0x481F, 0},
+
+	// unknown modifier choice: nothing is remapped, whatever is held down
+	{"period, bad modifier",	TEST_MAP_BAD_MODIFIER,	keyDown,	0x2F2E, 0,						0x2F2E, 0},
+	{"keypad 8, bad modifier",	TEST_MAP_BAD_MODIFIER,	keyDown,	0x5B38, alphaLock | optionKey,	0x5B38, alphaLock | optionKey},
+	{"keypad 8 repeat",			TEST_MAP_BAD_MODIFIER,	autoKey,	0x5B38, 0,						0x5B38, 0},
+};
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(void)
+{
+	CursorsRemapState	the_state = {0, false};
+	EventRecord			the_event;
+	const RemapTestCase*	the_case;
+	size_t				i;
+	int					failures = 0;
+
+	for (i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++)
+	{
+		the_case = &test_cases[i];
+
+		memset(&the_event, 0, sizeof(the_event));
+		the_event.what = the_case->what;
+		the_event.message = the_case->message_in;
+		the_event.modifiers = the_case->modifiers_in;
+
+		CursorsRemapEvent(&the_event, &test_maps[the_case->map], &the_state);
+
+		if (the_event.message != the_case->message_out || the_event.modifiers != the_case->modifiers_out)
+		{
+			fprintf(stderr, "FAIL: %s: got %04X/%04X, expected %04X/%04X\n", the_case->name,
+				(unsigned)the_event.message, (unsigned)(uint16_t)the_event.modifiers,
+				(unsigned)the_case->message_out, (unsigned)(uint16_t)the_case->modifiers_out);
+			failures++;
+		}
+	}
+
+	if (failures > 0)
+	{
+		fprintf(stderr, "remap_test: %d of %u case(s) FAILED\n", failures, (unsigned)i);
+		return 1;
+	}
+
+	printf("remap_test: all %u cases passed\n", (unsigned)i);
+	return 0;
+}
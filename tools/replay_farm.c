@@ -0,0 +1,960 @@
+/*
+ * replay_farm.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Replays recorded sessions through the remap core on all host cores. Each
+ *  session is a file in journal format (see cursors_journal.h: EventRecords,
+ *  68k byte order, no header). Each one goes through CursorsRemapEvents()
+ *  (remap_batch.c) with its own repeat state, in order, as the INIT would
+ *  have seen it.
+ *
+ * Sessions are the unit of work: one must be replayed in order, but any
+ *  number can run side by side. They are dealt out to one deque per worker
+ *  thread. A worker takes work from the bottom of its own deque, and when it
+ *  runs dry it steals from the top of another's. So a few long sessions
+ *  don't leave the other threads idle.
+ *
+ * Each session is replayed with its own keymap: a keymap file after the
+ *  second colon (session.jrn:expected.jrn:keymap, or session.jrn::keymap with
+ *  no expected file). A keymap file is a CursorsKeymap in 68k byte order, the
+ *  same 14 bytes as the INIT's ResEdit-editable keymap. Sessions without one
+ *  use the INIT's defaults, with the modifier from -m.
+ *
+ * For every session it prints what the replay changed. With an expected
+ *  file it also prints how many events came out different from it, and the
+ *  first one that did. Then it prints a scaling report: the same farm at 1,
+ *  2, 4... threads up to -j, with aggregate events/s. It also checks that
+ *  every thread count gives the same output.
+ *
+ * What a replay checks depends on what went in. A journal the INIT recorded
+ *  holds what the app got, so its keys are already remapped. Replaying it
+ *  with the keymap it was recorded with must change nothing: a changed event
+ *  is a key that reached the app without the remap it should have had
+ *  (another INIT's handler undid it, or the keymap is not the one that was
+ *  in use). -r makes any changed event a failure. It does not test the
+ *  remap itself; for that, replay events as typed, before the remap, against
+ *  an expected file.
+ *
+ * With no session files it runs a self-test. It writes a set of uneven
+ *  synthetic sessions with different keymaps as journal and keymap files,
+ *  plants one difference in one expected file, and checks the farm against
+ *  the one-by-one remap core. Then it replays the expected files as if the
+ *  INIT had recorded them, and checks that nothing changes.
+ *
+ * Usage: replay_farm [-j threads] [-m modifier] [-r] [session.jrn[:[expected.jrn][:keymap]] ...]
+ *   -j  most threads to try (default: one per online CPU, at least 4)
+ *   -m  modifier choice of the default keymap (0, 1, 2; default 2, as the
+ *       INIT ships). Keys and codes are the INIT's defaults.
+ *   -r  the sessions are journals the INIT recorded: fail if the replay
+ *       changes any event
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_keymap.h"
+#include "cursors_remap.h"
+#include "remap_batch.h"
+
+// C includes
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define FARM_MAX_THREADS			64
+#define FARM_RECORD_SIZE			16		// one EventRecord in a journal file
+#define FARM_KEYMAP_SIZE			14		// one CursorsKeymap in a keymap file
+#define FARM_TIMED_RUNS				3		// best of, per thread count
+
+#define FARM_TEST_SESSIONS			48
+#define FARM_TEST_MIN_EVENTS		2000
+#define FARM_TEST_MAX_EVENTS		200000
+#define FARM_TEST_PLANTED_SESSION	17		// its expected file gets one event changed
+#define FARM_TEST_PLANTED_EVENT		1234
+#define FARM_TEST_NUM_MAPS			3
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct FarmSession
+{
+	char*			path;
+	char*			expected_path;		// or NULL
+	char*			keymap_path;		// or NULL: the default keymap
+	CursorsKeymap	map;				// what the session is replayed with
+	EventRecord*	events;				// as recorded, host byte order
+	EventRecord*	expected;			// or NULL
+	EventRecord*	output;				// the replay
+	size_t			num_events;
+	size_t			num_expected;
+	size_t			changed;			// events the replay changed
+	size_t			mismatched;			// output events different from expected
+	long			first_mismatch;		// index, or -1
+} FarmSession;
+
+// LOGIC:
+//   one lock per deque. the owner pops at the bottom, thieves take from the
+//   top, so they only meet on the last task. tasks are session indexes and
+//   are never added once the farm starts, so "every deque empty" means done.
+typedef struct FarmDeque
+{
+	pthread_mutex_t	lock;
+	int*			task;
+	int				top;				// next to steal
+	int				bottom;				// one past the next to pop
+} FarmDeque;
+
+typedef struct FarmWorker
+{
+	pthread_t		thread;
+	int				id;
+	FarmDeque		deque;
+	int				sessions_run;
+	int				steals;
+} FarmWorker;
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+static FarmSession*		farm_session;
+static int				farm_num_sessions;
+static FarmWorker		farm_worker[FARM_MAX_THREADS];
+static int				farm_num_workers;
+static CursorsKeymap	farm_map;				// for sessions without a keymap file
+static bool				farm_recorded = false;	// -r: sessions are post-remap journals
+
+// the INIT's ResEdit defaults (custom_cursors.c)
+static const CursorsKeymap	farm_default_map =
+{
+	{0x18, 0x21, 0x1E, 0x2A}, MODIFIER_CAPSLOCK_MODE_2, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}
+};
+
+// self-test keymaps: the default, option, and IJKL with plain capslock
+static const CursorsKeymap	farm_test_map[FARM_TEST_NUM_MAPS] =
+{
+	{{0x18, 0x21, 0x1E, 0x2A}, MODIFIER_CAPSLOCK_MODE_2, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x18, 0x21, 0x1E, 0x2A}, MODIFIER_OPT_KEY, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}},
+	{{0x22, 0x26, 0x28, 0x25}, MODIFIER_CAPSLOCK_MODE_1, 0, {0x4D1E, 0x461C, 0x481F, 0x421D}}
+};
+
+static uint32_t			farm_random = 1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Reads a journal file
+// @return	Returns the events in host byte order, or NULL if unreadable
+static EventRecord* FarmReadJournal(const char *path, size_t *num_events);
+
+// Writes a journal file
+// @return	Returns true if it was written
+static bool FarmWriteJournal(const char *path, const EventRecord *events, size_t num_events);
+
+// Reads a keymap file
+// @return	Returns true if it was read
+static bool FarmReadKeymap(const char *path, CursorsKeymap *map);
+
+// Writes a keymap file
+// @return	Returns true if it was written
+static bool FarmWriteKeymap(const char *path, const CursorsKeymap *map);
+
+// Replays one session and compares it with what was expected
+static void FarmReplay(FarmSession *session);
+
+// @return	Returns a session index from the worker's own deque, or stolen, or -1 if none left
+static int FarmNextTask(FarmWorker *worker);
+
+static void* FarmWorkerMain(void *argument);
+
+// Deals the sessions out and replays them all on num_threads threads
+// @return	Returns the wall time in seconds
+static double FarmRun(int num_threads);
+
+// Prints one line per session
+static void FarmReport(void);
+
+// Runs the farm at 1, 2, 4... max_threads threads, checking every output
+//  against the first run's
+// @return	Returns the number of thread counts whose output differed
+static int FarmScaling(int max_threads);
+
+// Small LCG, so every run writes the same sessions
+static uint32_t FarmRandom(void);
+
+// Writes synthetic sessions, and their expected output, as journal files,
+//  each with its keymap file
+// @return	Returns the directory they are in, or NULL
+static char* FarmMakeTestSessions(void);
+
+// The self-test: farm over the synthetic sessions, against the remap core one by one
+// @return	Returns the number of failed checks
+static int FarmSelfTest(int max_threads);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Reads a journal file
+// @return	Returns the events in host byte order, or NULL if unreadable
+static EventRecord* FarmReadJournal(const char *path, size_t *num_events)
+{
+	FILE*			the_file;
+	EventRecord*	events;
+	uint8_t			b[FARM_RECORD_SIZE];
+	long			size;
+	size_t			i;
+
+	the_file = fopen(path, "rb");
+
+	if (the_file == NULL)
+	{
+		return NULL;
+	}
+
+	fseek(the_file, 0, SEEK_END);
+	size = ftell(the_file);
+	fseek(the_file, 0, SEEK_SET);
+
+	*num_events = size / FARM_RECORD_SIZE;
+	events = malloc((*num_events + 1) * sizeof(EventRecord));
+
+	for (i = 0; events != NULL && i < *num_events; i++)
+	{
+		if (fread(b, FARM_RECORD_SIZE, 1, the_file) != 1)
+		{
+			free(events);
+			events = NULL;
+			break;
+		}
+
+		// the 68k is big endian
+		events[i].what = (int16_t)((b[0] << 8) | b[1]);
+		events[i].message = (int32_t)(((uint32_t)b[2] << 24) | (b[3] << 16) | (b[4] << 8) | b[5]);
+		events[i].when = (int32_t)(((uint32_t)b[6] << 24) | (b[7] << 16) | (b[8] << 8) | b[9]);
+		events[i].where.v = (int16_t)((b[10] << 8) | b[11]);
+		events[i].where.h = (int16_t)((b[12] << 8) | b[13]);
+		events[i].modifiers = (int16_t)((b[14] << 8) | b[15]);
+	}
+
+	fclose(the_file);
+
+	return events;
+}
+
+
+// Writes a journal file
+// @return	Returns true if it was written
+static bool FarmWriteJournal(const char *path, const EventRecord *events, size_t num_events)
+{
+	FILE*		the_file;
+	uint8_t		b[FARM_RECORD_SIZE];
+	size_t		i;
+	bool		ok = true;
+
+	the_file = fopen(path, "wb");
+
+	if (the_file == NULL)
+	{
+		return false;
+	}
+
+	for (i = 0; ok && i < num_events; i++)
+	{
+		b[0] = events[i].what >> 8;					b[1] = events[i].what;
+		b[2] = events[i].message >> 24;				b[3] = events[i].message >> 16;
+		b[4] = events[i].message >> 8;				b[5] = events[i].message;
+		b[6] = events[i].when >> 24;				b[7] = events[i].when >> 16;
+		b[8] = events[i].when >> 8;					b[9] = events[i].when;
+		b[10] = events[i].where.v >> 8;				b[11] = events[i].where.v;
+		b[12] = events[i].where.h >> 8;				b[13] = events[i].where.h;
+		b[14] = events[i].modifiers >> 8;			b[15] = events[i].modifiers;
+
+		ok = (fwrite(b, FARM_RECORD_SIZE, 1, the_file) == 1);
+	}
+
+	return (fclose(the_file) == 0 && ok);
+}
+
+
+// Reads a keymap file
+// @return	Returns true if it was read
+static bool FarmReadKeymap(const char *path, CursorsKeymap *map)
+{
+	FILE*		the_file;
+	uint8_t		b[FARM_KEYMAP_SIZE];
+	bool		ok;
+	int			i;
+
+	the_file = fopen(path, "rb");
+
+	if (the_file == NULL)
+	{
+		return false;
+	}
+
+	// exactly one keymap, nothing after it
+	ok = (fread(b, FARM_KEYMAP_SIZE, 1, the_file) == 1 && fgetc(the_file) == EOF);
+	fclose(the_file);
+
+	for (i = 0; ok && i < CURSORS_NUM_KEYS; i++)
+	{
+		map->key[i] = b[i];
+		map->remap[i] = (uint16_t)((b[6 + 2 * i] << 8) | b[7 + 2 * i]);
+	}
+
+	map->modifier_choice = b[4];
+	map->reserved = b[5];
+
+	return ok;
+}
+
+
+// Writes a keymap file
+// @return	Returns true if it was written
+static bool FarmWriteKeymap(const char *path, const CursorsKeymap *map)
+{
+	FILE*		the_file;
+	uint8_t		b[FARM_KEYMAP_SIZE];
+	bool		ok;
+	int			i;
+
+	the_file = fopen(path, "wb");
+
+	if (the_file == NULL)
+	{
+		return false;
+	}
+
+	for (i = 0; i < CURSORS_NUM_KEYS; i++)
+	{
+		b[i] = map->key[i];
+		b[6 + 2 * i] = map->remap[i] >> 8;
+		b[7 + 2 * i] = map->remap[i];
+	}
+
+	b[4] = map->modifier_choice;
+	b[5] = map->reserved;
+
+	ok = (fwrite(b, FARM_KEYMAP_SIZE, 1, the_file) == 1);
+
+	return (fclose(the_file) == 0 && ok);
+}
+
+
+// Replays one session and compares it with what was expected
+static void FarmReplay(FarmSession *session)
+{
+	CursorsRemapState	the_state = {0, false};
+	size_t				i;
+
+	memcpy(session->output, session->events, session->num_events * sizeof(EventRecord));
+	CursorsRemapEvents(session->output, session->num_events, &session->map, &the_state);
+
+	session->changed = 0;
+	session->mismatched = 0;
+	session->first_mismatch = -1;
+
+	for (i = 0; i < session->num_events; i++)
+	{
+		if (memcmp(&session->output[i], &session->events[i], sizeof(EventRecord)) != 0)
+		{
+			session->changed++;
+		}
+
+		if (session->expected != NULL && (i >= session->num_expected || memcmp(&session->output[i], &session->expected[i], sizeof(EventRecord)) != 0))
+		{
+			if (session->first_mismatch < 0)
+			{
+				session->first_mismatch = (long)i;
+			}
+
+			session->mismatched++;
+		}
+	}
+
+	// an expected file longer than the session is a mismatch too
+	if (session->expected != NULL && session->num_expected > session->num_events)
+	{
+		if (session->first_mismatch < 0)
+		{
+			session->first_mismatch = (long)session->num_events;
+		}
+
+		session->mismatched += session->num_expected - session->num_events;
+	}
+}
+
+
+// @return	Returns a session index from the worker's own deque, or stolen, or -1 if none left
+static int FarmNextTask(FarmWorker *worker)
+{
+	FarmDeque*	victim;
+	int			task = -1;
+	int			i;
+
+	pthread_mutex_lock(&worker->deque.lock);
+
+	if (worker->deque.bottom > worker->deque.top)
+	{
+		task = worker->deque.task[--worker->deque.bottom];
+	}
+
+	pthread_mutex_unlock(&worker->deque.lock);
+
+	// own deque is dry: go round the others, starting with the next one
+	for (i = 1; task < 0 && i < farm_num_workers; i++)
+	{
+		victim = &farm_worker[(worker->id + i) % farm_num_workers].deque;
+
+		pthread_mutex_lock(&victim->lock);
+
+		if (victim->bottom > victim->top)
+		{
+			task = victim->task[victim->top++];
+			worker->steals++;
+		}
+
+		pthread_mutex_unlock(&victim->lock);
+	}
+
+	return task;
+}
+
+
+static void* FarmWorkerMain(void *argument)
+{
+	FarmWorker*	worker = argument;
+	int			task;
+
+	while ((task = FarmNextTask(worker)) >= 0)
+	{
+		FarmReplay(&farm_session[task]);
+		worker->sessions_run++;
+	}
+
+	return NULL;
+}
+
+
+// Deals the sessions out and replays them all on num_threads threads
+// @return	Returns the wall time in seconds
+static double FarmRun(int num_threads)
+{
+	struct timespec		start;
+	struct timespec		end;
+	FarmWorker*			worker;
+	int					i;
+
+	farm_num_workers = num_threads;
+
+	// round robin, in file order: the bottom of each deque (taken first by
+	//  its owner) is its last session, the top (taken first by thieves) its first
+	for (i = 0; i < num_threads; i++)
+	{
+		worker = &farm_worker[i];
+		worker->id = i;
+		worker->sessions_run = 0;
+		worker->steals = 0;
+		worker->deque.task = malloc((farm_num_sessions / num_threads + 1) * sizeof(int));
+		worker->deque.top = 0;
+		worker->deque.bottom = 0;
+		pthread_mutex_init(&worker->deque.lock, NULL);
+	}
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		worker = &farm_worker[i % num_threads];
+		worker->deque.task[worker->deque.bottom++] = i;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_threads; i++)
+	{
+		pthread_create(&farm_worker[i].thread, NULL, FarmWorkerMain, &farm_worker[i]);
+	}
+
+	for (i = 0; i < num_threads; i++)
+	{
+		pthread_join(farm_worker[i].thread, NULL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < num_threads; i++)
+	{
+		pthread_mutex_destroy(&farm_worker[i].deque.lock);
+		free(farm_worker[i].deque.task);
+	}
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+
+// Prints one line per session
+static void FarmReport(void)
+{
+	FarmSession*	session;
+	int				i;
+
+	printf("%-40s %10s %10s %10s %10s\n", "session", "events", "changed", "mismatched", "first");
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		session = &farm_session[i];
+
+		if (session->expected == NULL)
+		{
+			printf("%-40s %10zu %10zu %10s %10s\n", session->path, session->num_events, session->changed, "-", "-");
+		}
+		else if (session->first_mismatch < 0)
+		{
+			printf("%-40s %10zu %10zu %10zu %10s\n", session->path, session->num_events, session->changed, session->mismatched, "-");
+		}
+		else
+		{
+			printf("%-40s %10zu %10zu %10zu %10ld\n", session->path, session->num_events, session->changed, session->mismatched, session->first_mismatch);
+		}
+	}
+}
+
+
+// Runs the farm at 1, 2, 4... max_threads threads, checking every output
+//  against the first run's
+// @return	Returns the number of thread counts whose output differed
+static int FarmScaling(int max_threads)
+{
+	EventRecord**	first_output;
+	size_t			total_events = 0;
+	double			seconds;
+	double			best;
+	double			one_thread_rate = 0;
+	int				threads;
+	int				run;
+	int				steals;
+	int				i;
+	int				failures = 0;
+
+	first_output = calloc(farm_num_sessions, sizeof(EventRecord*));
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		total_events += farm_session[i].num_events;
+	}
+
+	printf("\n%zu sessions, %zu events, %ld online CPU(s)\n", (size_t)farm_num_sessions, total_events, sysconf(_SC_NPROCESSORS_ONLN));
+	printf("%8s %10s %12s %9s %8s\n", "threads", "wall ms", "Mevents/s", "speedup", "steals");
+
+	for (threads = 1; threads <= max_threads; threads = (threads * 2 > max_threads && threads < max_threads) ? max_threads : threads * 2)
+	{
+		best = 0;
+		steals = 0;
+
+		for (run = 0; run < FARM_TIMED_RUNS; run++)
+		{
+			seconds = FarmRun(threads);
+
+			if (run == 0 || seconds < best)
+			{
+				best = seconds;
+			}
+
+			for (i = 0; i < threads; i++)
+			{
+				steals += farm_worker[i].steals;
+			}
+		}
+
+		// same output, whatever the thread count
+		for (i = 0; i < farm_num_sessions; i++)
+		{
+			if (first_output[i] == NULL)
+			{
+				first_output[i] = malloc(farm_session[i].num_events * sizeof(EventRecord) + 1);
+				memcpy(first_output[i], farm_session[i].output, farm_session[i].num_events * sizeof(EventRecord));
+			}
+			else if (memcmp(first_output[i], farm_session[i].output, farm_session[i].num_events * sizeof(EventRecord)) != 0)
+			{
+				fprintf(stderr, "FAIL: %s came out different on %d threads\n", farm_session[i].path, threads);
+				failures++;
+			}
+		}
+
+		if (threads == 1)
+		{
+			one_thread_rate = total_events / best;
+		}
+
+		printf("%8d %10.2f %12.1f %8.2fx %8d\n", threads, best * 1e3, total_events / best / 1e6,
+			(total_events / best) / one_thread_rate, steals / FARM_TIMED_RUNS);
+	}
+
+	if (max_threads > sysconf(_SC_NPROCESSORS_ONLN))
+	{
+		printf("(more threads than online CPUs: those rows show the cost of the deques and thread switches, not a speedup)\n");
+	}
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		free(first_output[i]);
+	}
+
+	free(first_output);
+
+	return failures;
+}
+
+
+// Small LCG, so every run writes the same sessions
+static uint32_t FarmRandom(void)
+{
+	farm_random = farm_random * 1103515245 + 12345;
+	return (farm_random >> 8);
+}
+
+
+// Writes synthetic sessions, and their expected output, as journal files,
+//  each with its keymap file
+// @return	Returns the directory they are in, or NULL
+static char* FarmMakeTestSessions(void)
+{
+	static char		dir[] = "/tmp/replay_farm.XXXXXX";
+	static const int16_t	modifiers[] = {0, 0, 0, alphaLock, optionKey, shiftKey, alphaLock | shiftKey};
+	static const int16_t	others[] = {nullEvent, nullEvent, mouseDown, mouseUp};
+	CursorsRemapState	the_state;
+	const CursorsKeymap*	map;
+	EventRecord*	events;
+	char			path[64];
+	size_t			num_events;
+	size_t			i;
+	int				s;
+
+	if (mkdtemp(dir) == NULL)
+	{
+		return NULL;
+	}
+
+	events = malloc(FARM_TEST_MAX_EVENTS * sizeof(EventRecord));
+
+	for (s = 0; s < FARM_TEST_SESSIONS; s++)
+	{
+		map = &farm_test_map[s % FARM_TEST_NUM_MAPS];
+		snprintf(path, sizeof(path), "%s/s%02d.map", dir, s);
+		FarmWriteKeymap(path, map);
+
+		// uneven on purpose: a few long sessions among many short ones
+		num_events = (s % 7 == 0) ? FARM_TEST_MAX_EVENTS : FARM_TEST_MIN_EVENTS + FarmRandom() % (FARM_TEST_MAX_EVENTS / 8);
+
+		for (i = 0; i < num_events; i++)
+		{
+			memset(&events[i], 0, sizeof(EventRecord));
+			events[i].when = (int32_t)i;
+
+			if (FarmRandom() % 4 == 0)
+			{
+				events[i].what = others[FarmRandom() % 4];
+				continue;
+			}
+
+			events[i].what = (FarmRandom() % 3 == 0) ? autoKey : keyDown;
+			events[i].message = ((uint32_t)(0x10 + FarmRandom() % 0x20) << 8) | ('A' + FarmRandom() % 40);
+			events[i].modifiers = modifiers[FarmRandom() % 7];
+		}
+
+		snprintf(path, sizeof(path), "%s/s%02d.jrn", dir, s);
+		FarmWriteJournal(path, events, num_events);
+
+		// expected: the remap core, one event at a time
+		the_state.last_remapped_key = 0;
+		the_state.last_event_was_remap = false;
+
+		for (i = 0; i < num_events; i++)
+		{
+			if (events[i].what == keyDown || events[i].what == autoKey)
+			{
+				CursorsRemapEvent(&events[i], map, &the_state);
+			}
+		}
+
+		if (s == FARM_TEST_PLANTED_SESSION)
+		{
+			events[FARM_TEST_PLANTED_EVENT].message ^= 0x01;
+		}
+
+		snprintf(path, sizeof(path), "%s/s%02d.out", dir, s);
+		FarmWriteJournal(path, events, num_events);
+	}
+
+	free(events);
+
+	return dir;
+}
+
+
+// The self-test: farm over the synthetic sessions, against the remap core one by one
+// @return	Returns the number of failed checks
+static int FarmSelfTest(int max_threads)
+{
+	FarmSession*	session;
+	char*			dir;
+	char			path[64];
+	int				failures = 0;
+	int				s;
+
+	dir = FarmMakeTestSessions();
+
+	if (dir == NULL)
+	{
+		fprintf(stderr, "replay_farm: could not write the test sessions\n");
+		return 1;
+	}
+
+	farm_num_sessions = FARM_TEST_SESSIONS;
+	farm_session = calloc(farm_num_sessions, sizeof(FarmSession));
+
+	for (s = 0; s < FARM_TEST_SESSIONS; s++)
+	{
+		session = &farm_session[s];
+		snprintf(path, sizeof(path), "%s/s%02d.jrn", dir, s);
+		session->path = strdup(path);
+		session->events = FarmReadJournal(path, &session->num_events);
+		snprintf(path, sizeof(path), "%s/s%02d.out", dir, s);
+		session->expected_path = strdup(path);
+		session->expected = FarmReadJournal(path, &session->num_expected);
+		snprintf(path, sizeof(path), "%s/s%02d.map", dir, s);
+		session->keymap_path = strdup(path);
+		session->output = malloc(session->num_events * sizeof(EventRecord) + 1);
+
+		if (session->events == NULL || session->expected == NULL || !FarmReadKeymap(session->keymap_path, &session->map)
+			|| memcmp(&session->map, &farm_test_map[s % FARM_TEST_NUM_MAPS], sizeof(CursorsKeymap)) != 0)
+		{
+			fprintf(stderr, "FAIL: could not read back %s\n", session->path);
+			failures++;
+		}
+
+		unlink(session->path);
+		unlink(session->expected_path);
+		unlink(session->keymap_path);
+	}
+
+	rmdir(dir);
+
+	if (failures > 0)
+	{
+		return failures;
+	}
+
+	failures += FarmScaling(max_threads);
+
+	// the farm agrees with the remap core everywhere but where the difference was planted
+	for (s = 0; s < FARM_TEST_SESSIONS; s++)
+	{
+		session = &farm_session[s];
+
+		if (s == FARM_TEST_PLANTED_SESSION)
+		{
+			if (session->mismatched != 1 || session->first_mismatch != FARM_TEST_PLANTED_EVENT)
+			{
+				fprintf(stderr, "FAIL: planted difference in %s not reported (%zu at %ld)\n", session->path, session->mismatched, session->first_mismatch);
+				failures++;
+			}
+		}
+		else if (session->mismatched != 0)
+		{
+			fprintf(stderr, "FAIL: %s: %zu event(s) differ from the remap core, first at %ld\n", session->path, session->mismatched, session->first_mismatch);
+			failures++;
+		}
+	}
+
+	// the expected files are what the app got, as a journal the INIT recorded
+	//  would be: replayed with the same keymaps, nothing is left to remap
+	for (s = 0; s < FARM_TEST_SESSIONS; s++)
+	{
+		session = &farm_session[s];
+		memcpy(session->events, session->expected, session->num_events * sizeof(EventRecord));
+		free(session->expected);
+		session->expected = NULL;
+	}
+
+	FarmRun(max_threads);
+
+	for (s = 0; s < FARM_TEST_SESSIONS; s++)
+	{
+		session = &farm_session[s];
+
+		if (session->changed != 0)
+		{
+			fprintf(stderr, "FAIL: %s: recorded (remapped) session changed by the replay, %zu event(s)\n", session->expected_path, session->changed);
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	FarmSession*	session;
+	char*			colon;
+	char*			keymap_colon;
+	long			max_threads;
+	int				option;
+	int				failures = 0;
+	int				i;
+
+	max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	// on a small machine, still show what more threads do
+	if (max_threads < 4)
+	{
+		max_threads = 4;
+	}
+
+	farm_map = farm_default_map;
+
+	while ((option = getopt(argc, argv, "j:m:r")) != -1)
+	{
+		switch (option)
+		{
+			case 'j':
+				max_threads = atol(optarg);
+				break;
+
+			case 'm':
+				farm_map.modifier_choice = (uint8_t)atoi(optarg);
+				break;
+
+			case 'r':
+				farm_recorded = true;
+				break;
+
+			default:
+				fprintf(stderr, "usage: replay_farm [-j threads] [-m modifier] [-r] [session.jrn[:[expected.jrn][:keymap]] ...]\n");
+				return 2;
+		}
+	}
+
+	if (max_threads < 1 || max_threads > FARM_MAX_THREADS)
+	{
+		max_threads = (max_threads < 1) ? 1 : FARM_MAX_THREADS;
+	}
+
+	if (optind == argc)
+	{
+		failures = FarmSelfTest((int)max_threads);
+
+		if (failures > 0)
+		{
+			fprintf(stderr, "replay_farm: %d check(s) FAILED\n", failures);
+			return 1;
+		}
+
+		printf("replay_farm: all checks passed\n");
+		return 0;
+	}
+
+	farm_num_sessions = argc - optind;
+	farm_session = calloc(farm_num_sessions, sizeof(FarmSession));
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		session = &farm_session[i];
+		session->path = strdup(argv[optind + i]);
+		session->map = farm_map;
+		colon = strchr(session->path, ':');
+		keymap_colon = (colon != NULL) ? strchr(colon + 1, ':') : NULL;
+
+		if (keymap_colon != NULL)
+		{
+			*keymap_colon = '\0';
+			session->keymap_path = keymap_colon + 1;
+
+			if (!FarmReadKeymap(session->keymap_path, &session->map))
+			{
+				fprintf(stderr, "replay_farm: can't read keymap %s\n", session->keymap_path);
+				return 1;
+			}
+		}
+
+		if (colon != NULL)
+		{
+			*colon = '\0';
+		}
+
+		if (colon != NULL && colon[1] != '\0')
+		{
+			session->expected_path = colon + 1;
+			session->expected = FarmReadJournal(session->expected_path, &session->num_expected);
+
+			if (session->expected == NULL)
+			{
+				fprintf(stderr, "replay_farm: can't read %s\n", session->expected_path);
+				return 1;
+			}
+		}
+
+		session->events = FarmReadJournal(session->path, &session->num_events);
+
+		if (session->events == NULL)
+		{
+			fprintf(stderr, "replay_farm: can't read %s\n", session->path);
+			return 1;
+		}
+
+		session->output = malloc(session->num_events * sizeof(EventRecord) + 1);
+	}
+
+	failures = FarmScaling((int)max_threads);
+	printf("\n");
+	FarmReport();
+
+	for (i = 0; i < farm_num_sessions; i++)
+	{
+		if (farm_session[i].mismatched > 0)
+		{
+			failures++;
+		}
+
+		if (farm_recorded && farm_session[i].changed > 0)
+		{
+			fprintf(stderr, "replay_farm: %s: %zu event(s) changed: they reached the app unremapped, or this is not the keymap it was recorded with\n", farm_session[i].path, farm_session[i].changed);
+			failures++;
+		}
+	}
+
+	return (failures > 0) ? 1 : 0;
+}
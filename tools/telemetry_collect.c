@@ -0,0 +1,367 @@
+/*
+ * telemetry_collect.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host collector for the INIT's soak-test telemetry (cursors_telemetry.h):
+ *  reads the record stream from a serial device (or a pty, for tests), and
+ *  prints one line per record.
+ *
+ * The wire has no framing but the TELEMETRY_SYNC byte that starts every
+ *  8-byte record, and 0xCC can turn up in the data too. So a record is only
+ *  taken when it starts with the sync byte and a known kind, and the byte
+ *  after it is a sync byte again. Until then the collector skips a byte at a
+ *  time. That is how it joins mid-stream, and how it gets back in step after
+ *  line noise or lost bytes. The last record of the stream is taken on its
+ *  own at the end.
+ *
+ * Records are big endian, as the 68k sends them. Gaps in seq are reported:
+ *  the INIT drops records when its ring is full, and records lost to noise
+ *  show up the same way.
+ *
+ * Usage: telemetry_collect [-q] [-b baud] device
+ *   -q  only print the summary at the end
+ *   -b  port speed, if device is a serial port (default 57600, as the INIT)
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "cursors_telemetry.h"
+
+// C includes
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define COLLECT_RECORD_SIZE			8		// on the wire
+#define COLLECT_READ_SIZE			256
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct CollectState
+{
+	uint8_t		buffer[COLLECT_RECORD_SIZE + 1];	// a record and the next byte
+	int			length;
+	bool		have_seq;
+	uint16_t	last_seq;
+	bool		quiet;
+	uint32_t	skipping;			// bytes skipped since the last record taken
+	uint32_t	records;
+	uint32_t	gaps;
+	uint32_t	missing;
+	uint32_t	resyncs;
+	uint32_t	skipped;
+} CollectState;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// Opens the device, raw, and sets its speed if it is a serial port
+// @return	Returns a file descriptor, or -1
+static int CollectOpen(const char *path, long baud);
+
+// @return	Returns true if the buffer starts with what looks like a record
+static bool CollectLooksLikeRecord(const CollectState *state);
+
+// Decodes and prints the record at the start of the buffer, and drops it
+static void CollectTakeRecord(CollectState *state);
+
+// Feeds bytes from the wire through the state machine
+static void CollectFeed(CollectState *state, const uint8_t *bytes, size_t num_bytes);
+
+// End of the stream: takes the last record, if there is a whole one
+static void CollectFinish(CollectState *state);
+
+// The collector itself, on an open state
+// @return	Returns 0 on a clean end of stream, 1 on a read error
+static int CollectRun(int fd, CollectState *state);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// Opens the device, raw, and sets its speed if it is a serial port
+// @return	Returns a file descriptor, or -1
+static int CollectOpen(const char *path, long baud)
+{
+	struct termios	the_tty;
+	speed_t			speed;
+	int				fd;
+
+	fd = open(path, O_RDONLY | O_NOCTTY);
+
+	if (fd < 0 || !isatty(fd))
+	{
+		return fd;
+	}
+
+	switch (baud)
+	{
+		case 9600:		speed = B9600;		break;
+		case 19200:		speed = B19200;		break;
+		case 38400:		speed = B38400;		break;
+		case 115200:	speed = B115200;	break;
+		default:		speed = B57600;		break;
+	}
+
+	// 8N1, no handshaking, and no line discipline: 0x0D and 0x7F are data too
+	if (tcgetattr(fd, &the_tty) == 0)
+	{
+		cfmakeraw(&the_tty);
+		the_tty.c_cflag |= CLOCAL | CREAD;
+		the_tty.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+		the_tty.c_cc[VMIN] = 1;
+		the_tty.c_cc[VTIME] = 0;
+		cfsetispeed(&the_tty, speed);
+		cfsetospeed(&the_tty, speed);
+		tcsetattr(fd, TCSANOW, &the_tty);
+	}
+
+	return fd;
+}
+
+
+// @return	Returns true if the buffer starts with what looks like a record
+static bool CollectLooksLikeRecord(const CollectState *state)
+{
+	return (state->buffer[0] == TELEMETRY_SYNC
+		&& state->buffer[1] >= TELEMETRY_KIND_REMAP && state->buffer[1] <= TELEMETRY_KIND_DROPPED);
+}
+
+
+// Decodes and prints the record at the start of the buffer, and drops it
+static void CollectTakeRecord(CollectState *state)
+{
+	const uint8_t*	b = state->buffer;
+	uint8_t			kind;
+	uint16_t		seq;
+	uint32_t		data;
+	uint16_t		missing;
+
+	// big endian, as the 68k sends it
+	kind = b[1];
+	seq = (uint16_t)((b[2] << 8) | b[3]);
+	data = ((uint32_t)b[4] << 24) | ((uint32_t)b[5] << 16) | ((uint32_t)b[6] << 8) | b[7];
+
+	if (state->skipping > 0)
+	{
+		if (!state->quiet)
+		{
+			printf("-- %s, skipped %u byte(s)\n", (state->records == 0) ? "joined mid-stream" : "lost sync", state->skipping);
+		}
+
+		if (state->records > 0)
+		{
+			state->resyncs++;
+		}
+
+		state->skipped += state->skipping;
+		state->skipping = 0;
+	}
+
+	// seq is 16 bits and wraps
+	missing = (uint16_t)(seq - state->last_seq - 1);
+
+	if (state->have_seq && missing != 0)
+	{
+		if (!state->quiet)
+		{
+			printf("-- %u record(s) missing before seq %u\n", missing, seq);
+		}
+
+		state->gaps++;
+		state->missing += missing;
+	}
+
+	state->have_seq = true;
+	state->last_seq = seq;
+	state->records++;
+
+	if (!state->quiet)
+	{
+		switch (kind)
+		{
+			case TELEMETRY_KIND_REMAP:
+				printf("seq %5u  remap          key 0x%02X -> key 0x%02X char 0x%02X%s\n", seq,
+					data >> 24, (data >> 16) & 0xFF, (data >> 8) & 0xFF, (data & TELEMETRY_FLAG_REMAPPED) ? "  (remapped)" : "");
+				break;
+
+			case TELEMETRY_KIND_KEYS_SEEN:
+				printf("seq %5u  keys seen      %u\n", seq, data);
+				break;
+
+			case TELEMETRY_KIND_KEYS_REMAPPED:
+				printf("seq %5u  keys remapped  %u\n", seq, data);
+				break;
+
+			default:
+				printf("seq %5u  dropped        %u\n", seq, data);
+				break;
+		}
+	}
+
+	state->length -= COLLECT_RECORD_SIZE;
+	memmove(state->buffer, state->buffer + COLLECT_RECORD_SIZE, state->length);
+}
+
+
+// Feeds bytes from the wire through the state machine
+static void CollectFeed(CollectState *state, const uint8_t *bytes, size_t num_bytes)
+{
+	size_t		i;
+
+	for (i = 0; i < num_bytes; i++)
+	{
+		state->buffer[state->length++] = bytes[i];
+
+		// LOGIC:
+		//   the buffer fills up to one record and the byte after it. then
+		//   either that is a record (sync, known kind, and the next byte is
+		//   a sync byte again) and it is taken, or the first byte is skipped
+
+		while (state->length == COLLECT_RECORD_SIZE + 1)
+		{
+			if (CollectLooksLikeRecord(state) && state->buffer[COLLECT_RECORD_SIZE] == TELEMETRY_SYNC)
+			{
+				CollectTakeRecord(state);
+			}
+			else
+			{
+				state->skipping++;
+				state->length--;
+				memmove(state->buffer, state->buffer + 1, state->length);
+			}
+		}
+	}
+}
+
+
+// End of the stream: takes the last record, if there is a whole one
+static void CollectFinish(CollectState *state)
+{
+	if (state->length == COLLECT_RECORD_SIZE && CollectLooksLikeRecord(state))
+	{
+		CollectTakeRecord(state);
+	}
+
+	state->skipping += state->length;
+	state->skipped += state->skipping;
+
+	printf("telemetry_collect: %u record(s), %u gap(s) (%u missing), %u resync(s), %u byte(s) skipped\n",
+		state->records, state->gaps, state->missing, state->resyncs, state->skipped);
+}
+
+
+// The collector itself, on an open state
+// @return	Returns 0 on a clean end of stream, 1 on a read error
+static int CollectRun(int fd, CollectState *state)
+{
+	uint8_t		bytes[COLLECT_READ_SIZE];
+	ssize_t		num_read;
+
+	while ((num_read = read(fd, bytes, sizeof(bytes))) != 0)
+	{
+		if (num_read < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			// a pty whose other end closed: the end of the stream
+			if (errno == EIO)
+			{
+				break;
+			}
+
+			perror("telemetry_collect: read");
+			CollectFinish(state);
+			return 1;
+		}
+
+		CollectFeed(state, bytes, (size_t)num_read);
+		fflush(stdout);
+	}
+
+	CollectFinish(state);
+
+	return 0;
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(int argc, char *argv[])
+{
+	CollectState	the_state;
+	long			baud = 57600;
+	int				option;
+	int				fd;
+
+	memset(&the_state, 0, sizeof(the_state));
+
+	while ((option = getopt(argc, argv, "qb:")) != -1)
+	{
+		switch (option)
+		{
+			case 'q':
+				the_state.quiet = true;
+				break;
+
+			case 'b':
+				baud = atol(optarg);
+				break;
+
+			default:
+				fprintf(stderr, "usage: telemetry_collect [-q] [-b baud] device\n");
+				return 2;
+		}
+	}
+
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "usage: telemetry_collect [-q] [-b baud] device\n");
+		return 2;
+	}
+
+	fd = CollectOpen(argv[optind], baud);
+
+	if (fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	return CollectRun(fd, &the_state);
+}
@@ -0,0 +1,475 @@
+/*
+ * telemetry_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Custom Cursors contributors
+ */
+
+/* about
+ *
+ * Host simulation of the soak-test telemetry, from the INIT to the collector:
+ *  builds custom_cursors.c with CURSORS_USE_TELEMETRY against the fake Mac in
+ *  host/toolbox_host.c, types into it, and feeds what cursors_telemetry.c
+ *  sends out the modem port to telemetry_collect.c through a pty, as a serial
+ *  cable would.
+ *
+ * The fake Mac's serial writes go to host_serial_fd, a pipe here. The host
+ *  build writes its records in host byte order, so the simulation puts each
+ *  one back into 68k byte order on its way to the pty, as a real Mac would
+ *  have sent it. It also joins the collector mid-stream, after some bytes
+ *  that look like records, and loses three bytes of one record on the way.
+ *
+ * The collector runs as it would from the shell, in a child process reading
+ *  the pty's other end. The simulation checks what it prints: every record
+ *  decoded, the records the INIT's full ring dropped and the one lost on the
+ *  line reported as seq gaps, and one resync.
+ *
+ * After that, without the collector, it checks that a port write the Device
+ *  Manager refuses to queue doesn't stop the telemetry for good, and that an
+ *  INIT installed as a guest of another INIT's dispatcher, with no idle
+ *  calls, still sends from its key handler.
+ *
+ * Usage: telemetry_sim
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+// the INIT itself. its main() is the code resource entry point, not ours
+#define main	CursorsMain
+#include "custom_cursors.c"
+#undef main
+
+// and the collector. its main() is run in the child process
+#define main	CollectMain
+#include "telemetry_collect.c"
+#undef main
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIM_EVERY_EVENT				-1
+#define SIM_COUNTER_TICKS			60		// the INIT's counters go out once a second
+#define SIM_KEYS_BEFORE_IDLE		80		// more than the INIT's ring holds
+#define SIM_RING_HOLDS				63		// the ring always leaves one slot empty
+#define SIM_MAX_WIRE				4096
+#define SIM_MAX_OUTPUT				65536
+#define SIM_LOST_BYTES				3		// lost off the end of one record
+#define SIM_MAX_BLOCKERS			16		// more than the fake Mac queues
+#define SIM_JOINED_KEYS				20
+
+#define SIM_CHECK(condition, what)	SimCheck((condition), (what), __LINE__)
+
+
+/*****************************************************************************/
+/*                          File-scoped Variables                            */
+/*****************************************************************************/
+
+// bytes on the line before the collector joins: the tail of a record, and
+//  sync bytes followed by a known kind that aren't records
+static const uint8_t	sim_joined_after[] = {0x00, TELEMETRY_SYNC, 0x02, 0x13, TELEMETRY_SYNC, 0x07, TELEMETRY_SYNC, 0x01};
+
+static EventRecord		sim_next_event;		// what the "ROM" GetNextEvent hands out
+static ParamBlockRec	sim_blocker[SIM_MAX_BLOCKERS];	// writes that fill the fake Mac's I/O queue
+static CursorsDispatcher	sim_other_dispatcher;	// the other INIT's, in the joined run
+static long				sim_trap_addr;		// the patched GetNextEvent
+static int				sim_serial_pipe[2];
+
+static uint8_t			sim_wire[SIM_MAX_WIRE];		// in 68k byte order
+static int				sim_wire_length = 0;
+static char				sim_output[SIM_MAX_OUTPUT];	// what the collector printed
+static int				sim_failures = 0;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent);
+
+// One key event through the patched GetNextEvent
+static void SimType(uint8_t key, bool with_capslock);
+
+// One null event through the patched GetNextEvent, then lets every serial write
+//  the INIT starts finish
+static void SimIdle(void);
+
+// Gestalt function for the other INIT's dispatcher selector, in the joined run
+static pascal OSErr SimOtherGestalt(OSType selector, long *response);
+
+// Moves what the INIT wrote to the port onto the wire, in 68k byte order
+// @return	Returns the number of records moved
+static int SimTakeSerialOutput(void);
+
+// Runs the collector on the wire, through a pty
+// @return	Returns true if it ran and exited cleanly
+static bool SimCollect(void);
+
+// @return	Returns the number of times text appears in what the collector printed
+static int SimCountOutput(const char *text);
+
+static void SimCheck(bool condition, const char *what, int line);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+// The original GetNextEvent, as far as the INIT can tell
+static pascal Boolean SimROMGetNextEvent(short eventMask, EventRecord *theEvent)
+{
+	*theEvent = sim_next_event;
+	return (theEvent->what != nullEvent);
+}
+
+
+// One key event through the patched GetNextEvent
+static void SimType(uint8_t key, bool with_capslock)
+{
+	EventRecord		the_event;
+
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	sim_next_event.what = keyDown;
+	sim_next_event.message = (key << 8) | 'k';
+	sim_next_event.modifiers = with_capslock ? alphaLock : 0;
+
+	CallPascalB(SIM_EVERY_EVENT, &the_event, sim_trap_addr);
+}
+
+
+// One null event through the patched GetNextEvent, then lets every serial write
+//  the INIT starts finish
+static void SimIdle(void)
+{
+	EventRecord		the_event;
+
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	CallPascalB(SIM_EVERY_EVENT, &the_event, sim_trap_addr);
+
+	// each completion chains the next write, if there is more to send
+	while (HostCompleteIO() > 0)
+	{
+	}
+}
+
+
+// Gestalt function for the other INIT's dispatcher selector, in the joined run
+static pascal OSErr SimOtherGestalt(OSType selector, long *response)
+{
+	*response = (long)&sim_other_dispatcher;
+	return noErr;
+}
+
+
+// Moves what the INIT wrote to the port onto the wire, in 68k byte order
+// @return	Returns the number of records moved
+static int SimTakeSerialOutput(void)
+{
+	CursorsTelemetryRecord	the_record;
+	uint8_t*				b;
+	int						num_records = 0;
+
+	while (sim_wire_length + COLLECT_RECORD_SIZE <= SIM_MAX_WIRE
+		&& read(sim_serial_pipe[0], &the_record, sizeof(the_record)) == sizeof(the_record))
+	{
+		b = &sim_wire[sim_wire_length];
+		b[0] = the_record.sync;
+		b[1] = the_record.kind;
+		b[2] = the_record.seq >> 8;
+		b[3] = the_record.seq;
+		b[4] = the_record.data >> 24;
+		b[5] = the_record.data >> 16;
+		b[6] = the_record.data >> 8;
+		b[7] = the_record.data;
+		sim_wire_length += COLLECT_RECORD_SIZE;
+		num_records++;
+	}
+
+	return num_records;
+}
+
+
+// Runs the collector on the wire, through a pty
+// @return	Returns true if it ran and exited cleanly
+static bool SimCollect(void)
+{
+	struct termios	the_tty;
+	char*			collect_argv[] = {"telemetry_collect", NULL, NULL};
+	int				output_pipe[2];
+	int				master;
+	int				slave;
+	int				waiting;
+	int				quiet_checks = 0;
+	int				output_length = 0;
+	ssize_t			num_read;
+	pid_t			child;
+	int				status;
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 || pipe(output_pipe) != 0)
+	{
+		return false;
+	}
+
+	// raw before anything is written, so the line discipline can't touch the
+	//  bytes before the collector sets it up. kept open to watch the queue
+	collect_argv[1] = ptsname(master);
+	slave = open(collect_argv[1], O_RDWR | O_NOCTTY);
+	tcgetattr(slave, &the_tty);
+	cfmakeraw(&the_tty);
+	tcsetattr(slave, TCSANOW, &the_tty);
+
+	child = fork();
+
+	if (child == 0)
+	{
+		dup2(output_pipe[1], STDOUT_FILENO);
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+		close(master);
+		close(slave);
+		exit(CollectMain(2, collect_argv));
+	}
+
+	close(output_pipe[1]);
+
+	if (write(master, sim_wire, sim_wire_length) != sim_wire_length)
+	{
+		return false;
+	}
+
+	// hang up only once the collector has read everything
+	while (quiet_checks < 3)
+	{
+		usleep(10000);
+
+		if (ioctl(slave, FIONREAD, &waiting) == 0 && waiting == 0)
+		{
+			quiet_checks++;
+		}
+		else
+		{
+			quiet_checks = 0;
+		}
+	}
+
+	close(slave);
+	close(master);
+
+	while ((num_read = read(output_pipe[0], sim_output + output_length, SIM_MAX_OUTPUT - 1 - output_length)) > 0)
+	{
+		output_length += num_read;
+	}
+
+	sim_output[output_length] = '\0';
+	close(output_pipe[0]);
+
+	return (waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+
+// @return	Returns the number of times text appears in what the collector printed
+static int SimCountOutput(const char *text)
+{
+	const char*	found = sim_output;
+	int			count = 0;
+
+	while ((found = strstr(found, text)) != NULL)
+	{
+		count++;
+		found += strlen(text);
+	}
+
+	return count;
+}
+
+
+static void SimCheck(bool condition, const char *what, int line)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAIL (line %d): %s\n", line, what);
+		sim_failures++;
+	}
+}
+
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+int main(void)
+{
+	char	expected[160];
+	int		num_records = 0;
+	int		lost_record;
+	int		i;
+
+	if (!HostCheckAddresses())
+	{
+		fprintf(stderr, "telemetry_sim: addresses don't fit in 32 bits; link with -no-pie\n");
+		return 1;
+	}
+
+	if (pipe(sim_serial_pipe) != 0 || fcntl(sim_serial_pipe[0], F_SETFL, O_NONBLOCK) != 0)
+	{
+		fprintf(stderr, "telemetry_sim: no pipe for the serial port\n");
+		return 1;
+	}
+
+	HostResetToolbox();
+	host_serial_fd = sim_serial_pipe[1];
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+
+	CursorsInstall();
+	sim_trap_addr = NGetTrapAddress((int)GetNextEventTrap, ToolTrap);
+
+	if (sim_trap_addr != (long)NewGetNextEvent)
+	{
+		fprintf(stderr, "telemetry_sim: CursorsInstall() did not patch GetNextEvent\n");
+		return 1;
+	}
+
+	// the collector joins after the line has been running a while
+	memcpy(sim_wire, sim_joined_after, sizeof(sim_joined_after));
+	sim_wire_length = sizeof(sim_joined_after);
+
+	// first idle: the counters, all zero
+	SimIdle();
+	num_records += SimTakeSerialOutput();
+
+	// typing with no idle time between keys, every other one remapped (the
+	//  INIT's default modifier is CapsLock): the ring fills and drops the rest
+	for (i = 0; i < SIM_KEYS_BEFORE_IDLE; i++)
+	{
+		SimType((i & 1) ? 0x2F : cursors_key[i & 3], (i & 1) == 0);
+	}
+
+	SimIdle();
+	num_records += SimTakeSerialOutput();
+
+	// a second on: the counters again, with the drops
+	host_tick_count += SIM_COUNTER_TICKS;
+	SimIdle();
+	num_records += SimTakeSerialOutput();
+
+	for (i = 0; i < 6; i++)
+	{
+		SimType(cursors_key[i & 3], true);
+	}
+
+	SimIdle();
+	num_records += SimTakeSerialOutput();
+
+	SIM_CHECK(num_records == 3 + SIM_RING_HOLDS + 3 + 6, "INIT sent the counters, a full ring, the counters, and 6 keys");
+
+	// noise on the line: the end of the third last record is lost
+	lost_record = num_records - 3;
+	i = sizeof(sim_joined_after) + (lost_record + 1) * COLLECT_RECORD_SIZE;
+	memmove(&sim_wire[i - SIM_LOST_BYTES], &sim_wire[i], sim_wire_length - i);
+	sim_wire_length -= SIM_LOST_BYTES;
+
+	SIM_CHECK(SimCollect(), "collector ran and exited cleanly");
+
+	snprintf(expected, sizeof(expected), "telemetry_collect: %d record(s), 2 gap(s) (%d missing), 1 resync(s), %d byte(s) skipped\n",
+		num_records - 1, SIM_KEYS_BEFORE_IDLE - SIM_RING_HOLDS + 1, (int)sizeof(sim_joined_after) + COLLECT_RECORD_SIZE - SIM_LOST_BYTES);
+	SIM_CHECK(strstr(sim_output, expected) != NULL, "summary: every record but the damaged one, both gaps, one resync");
+
+	snprintf(expected, sizeof(expected), "-- %d record(s) missing before seq", SIM_KEYS_BEFORE_IDLE - SIM_RING_HOLDS);
+	SIM_CHECK(SimCountOutput(expected) == 1, "the ring's drops show as one gap");
+
+	snprintf(expected, sizeof(expected), "dropped        %d\n", SIM_KEYS_BEFORE_IDLE - SIM_RING_HOLDS);
+	SIM_CHECK(SimCountOutput(expected) == 1, "the INIT counted the same drops");
+
+	snprintf(expected, sizeof(expected), "keys remapped  %d\n", SIM_KEYS_BEFORE_IDLE / 2);
+	SIM_CHECK(SimCountOutput(expected) == 1, "the INIT counted every other key as remapped");
+
+	SIM_CHECK(SimCountOutput("-- joined mid-stream, skipped 8 byte(s)") == 1, "joined after the look-alike bytes");
+	SIM_CHECK(SimCountOutput("-- 1 record(s) missing before seq") == 1, "the damaged record shows as a gap");
+
+	// the first key typed: the INIT's default key 0 remapped to its default right arrow
+	snprintf(expected, sizeof(expected), "remap          key 0x%02X -> key 0x%02X char 0x%02X  (remapped)\n",
+		cursors_key[0], cursors_remap[0] >> 8, cursors_remap[0] & 0xFF);
+	SIM_CHECK(strstr(sim_output, expected) != NULL, "remapped key decoded big endian");
+	SIM_CHECK(SimCountOutput("remap          key 0x2F -> key 0x2F char 0x6B\n") == SIM_RING_HOLDS / 2, "keys left alone decoded");
+
+	// the I/O queue is full, so the INIT's next write fails before it is
+	//  queued: that key is dropped, and the next idle sends again
+	for (i = 0; i < SIM_MAX_BLOCKERS && PBWrite(&sim_blocker[i], true) == noErr; i++)
+	{
+	}
+
+	SimType(cursors_key[0], true);
+	memset(&sim_next_event, 0, sizeof(EventRecord));
+	CallPascalB(SIM_EVERY_EVENT, &sim_next_event, sim_trap_addr);
+	SimIdle();
+	SIM_CHECK(SimTakeSerialOutput() == 0, "the key whose write failed is dropped");
+	SimType(cursors_key[1], true);
+	SimIdle();
+	SIM_CHECK(SimTakeSerialOutput() == 1, "the next idle sends again");
+
+	// installed again, joining another INIT's dispatcher: no idle calls
+	HostResetToolbox();
+	NSetTrapAddress((long)SimROMGetNextEvent, (int)GetNextEventTrap, ToolTrap);
+	NSetTrapAddress((long)Gestalt, (int)GestaltTrap, OSTrap);
+	sim_other_dispatcher.version = CURSORS_DISPATCH_VERSION;
+	NewGestalt(CURSORS_DISPATCH_SELECTOR, (ProcPtr)SimOtherGestalt);
+	cursors_owns_trap = false;
+	CursorsInstall();
+	SIM_CHECK(sim_other_dispatcher.handler_count == 1 && sim_other_dispatcher.handler[0] == CursorsRemapKey, "joined the other INIT's dispatcher");
+
+	// the fake Mac's clock started over, the INIT's statics did not: move
+	//  past the counters the first run set up
+	num_records = 0;
+	host_tick_count = 10 * SIM_COUNTER_TICKS;
+
+	for (i = 0; i < SIM_JOINED_KEYS; i++)
+	{
+		memset(&sim_next_event, 0, sizeof(EventRecord));
+		sim_next_event.what = keyDown;
+		sim_next_event.message = (cursors_key[i & 3] << 8) | 'k';
+		sim_next_event.modifiers = alphaLock;
+		CursorsDispatchKey(&sim_other_dispatcher, &sim_next_event);
+
+		while (HostCompleteIO() > 0)
+		{
+		}
+
+		num_records += SimTakeSerialOutput();
+	}
+
+	SIM_CHECK(num_records == 3 + SIM_JOINED_KEYS, "the key handler sent the counters and every key");
+
+	if (sim_failures > 0)
+	{
+		fprintf(stderr, "%s", sim_output);
+		fprintf(stderr, "telemetry_sim: %d check(s) FAILED\n", sim_failures);
+		return 1;
+	}
+
+	printf("telemetry_sim: all checks passed\n");
+	return 0;
+}
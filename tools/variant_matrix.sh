@@ -0,0 +1,107 @@
+#!/bin/sh
+#
+# variant_matrix.sh
+#
+# Builds each INIT variant from its own source for the host, and prints a
+#  Markdown table of what it costs: the object size of the variant's project
+#  (custom_cursors.c plus the modules it needs) and the per-event overhead
+#  that init_bench measures through the patched GetNextEvent.
+#
+# Rows are the two real variants, then the full INIT with one build option
+#  flipped at a time, so each option's cost is the difference from "full".
+#
+# Sizes are x86-64 -Os object sizes (text + data + bss), times are host
+#  ns/event. Neither is a 68000 number: they rank variants and changes
+#  against each other. The times move by up to a third from run to run and
+#  build to build (code alignment), so only bigger differences mean anything. cursors_show_icon.c is QuickDraw code
+#  that is not built on the host; the "icon" column says which variants
+#  include it. Needs gcc (or a cc that takes gcc's flags).
+#
+#   make -C tools matrix        or        sh tools/variant_matrix.sh [events]
+#
+# With -s it prints only the "full" total (no bench), for make to build
+#  heap_sim with.
+
+set -e
+cd "$(dirname "$0")"
+
+CC=${CC:-cc}
+SIZE_ONLY=0
+[ "$1" = "-s" ] && SIZE_ONLY=1 && shift
+EVENTS=${1:-100000}
+SRC=build/src
+OUT=build/matrix
+CPPFLAGS="-I$SRC -I.. -Ihost"
+# same as INIT_CFLAGS in the Makefile: keep the ResEdit bytes variables. the
+#  many host warnings 68k code gives are shown by make -C tools, not here
+INITFLAGS="-fno-ipa-reference-addressable -w"
+
+make -s --no-print-directory $SRC/custom_cursors.c $SRC/custom_cursors_no_frills.c $SRC/cursors_journal.c $SRC/cursors_telemetry.c
+mkdir -p $OUT
+
+# name|wrapper source|extra options
+VARIANTS="full|custom_cursors.c|
+low mem|custom_cursors_no_frills.c|
+full, no hot-key|custom_cursors.c|-DCURSORS_USE_HOTKEY=0
+full, no jGNEFilter mode|custom_cursors.c|-DCURSORS_USE_GNE_FILTER=0
+full, no layouts|custom_cursors.c|-DCURSORS_USE_LAYOUTS=0
+full, no journal|custom_cursors.c|-DCURSORS_USE_JOURNAL=0
+full + code copy|custom_cursors.c|-DCURSORS_USE_CODE_COPY=1
+full + telemetry|custom_cursors.c|-DCURSORS_USE_TELEMETRY=1"
+
+# object size in bytes: text + data + bss
+object_size()
+{
+	$CC -Os $INITFLAGS $CPPFLAGS $2 -Dmain=CursorsMain -c "$1" -o $OUT/size.o
+	size $OUT/size.o | awk 'NR == 2 { print $4 }'
+}
+
+# sets $modules and $show_icon: what the wrapper $1 plus options $2 turn on,
+#  as the preprocessor sees it
+modules_for()
+{
+	set -- $(printf '#include "%s"\n@@ CURSORS_USE_JOURNAL CURSORS_USE_TELEMETRY CURSORS_SHOW_ICON\n' "$1" \
+		| $CC -E -P $CPPFLAGS $2 -x c - | grep '^@@')
+	use_journal=$2
+	use_telemetry=$3
+	show_icon=$4
+
+	modules="../cursors_dispatch.c ../cursors_keymap.c ../cursors_remap.c"
+	[ "$use_journal" = 1 ] && modules="$modules $SRC/cursors_journal.c"
+	[ "$use_telemetry" = 1 ] && modules="$modules $SRC/cursors_telemetry.c"
+	return 0
+}
+
+# object size of the modules in $modules, built with options $1
+modules_size()
+{
+	module_size=0
+	for m in $modules; do
+		module_size=$((module_size + $(object_size $m "$1")))
+	done
+	echo $module_size
+}
+
+if [ $SIZE_ONLY = 1 ]; then
+	modules_for custom_cursors.c ""
+	echo $(($(object_size $SRC/custom_cursors.c "") + $(modules_size "")))
+	exit 0
+fi
+
+echo "| variant | custom_cursors.c | modules | total | icon | remapped key | other key | null event |"
+echo "|---|--:|--:|--:|:-:|--:|--:|--:|"
+
+echo "$VARIANTS" | while IFS='|' read -r name src opts; do
+	modules_for $src "$opts"
+	init_size=$(object_size $SRC/$src "$opts")
+	module_size=$(modules_size "$opts")
+
+	[ "$show_icon" = 1 ] && icon=yes || icon=no
+
+	# the bench includes the INIT source itself, with the same options
+	$CC -O2 $INITFLAGS $CPPFLAGS $opts -DCURSORS_INIT_SRC="\"$src\"" -no-pie -o $OUT/init_bench \
+		init_bench.c host/toolbox_host.c $modules
+	overhead=$($OUT/init_bench $EVENTS | awk '/^(remapped key|other key|null event)/ { printf "%s | ", $NF }')
+
+	echo "| $name | $init_size | $module_size | $((init_size + module_size)) | $icon | $overhead"
+done